@@ -0,0 +1,233 @@
+#pragma once
+
+/*
+	Queue of outgoing bytes for one connection, flushed with a single gathered write.
+
+	Small writes are copied into the tail chunk so a burst of tiny messages becomes one contiguous
+	region, shared buffers are queued by reference without copying. flush() hands up to max_iov_v
+	regions to a single sendmsg call on Unix, other targets send the front region only.
+*/
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+#include <cnet/buffer/SharedBuffer.h>
+
+#include <jclib/exception.h>
+
+#include <deque>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#ifdef CCAP_NET_UNIX
+#include <sys/uio.h>
+#endif
+
+namespace ccap::net
+{
+	/**
+	 * @brief Largest number of regions gathered into one flush, well under the Linux IOV_MAX of 1024
+	*/
+	constexpr inline size_t max_iov_v = 64;
+
+	/**
+	 * @brief Size of the chunks small writes are coalesced into
+	*/
+	constexpr inline size_t send_chunk_size_v = 16 * 1024;
+
+	/**
+	 * @brief Pending writes for a single connection, not thread safe
+	*/
+	struct SendQueue
+	{
+	public:
+		using size_type = size_t;
+
+		/**
+		 * @brief Total number of bytes waiting to be sent
+		*/
+		size_type size() const noexcept
+		{
+			return this->bytes_;
+		};
+		bool empty() const noexcept
+		{
+			return this->bytes_ == 0;
+		};
+
+		/**
+		 * @brief Number of separate regions queued, each costs one iovec when flushed
+		*/
+		size_type regions() const noexcept
+		{
+			return this->entries_.size();
+		};
+
+		/**
+		 * @brief Queues a copy of the given bytes, appending to the tail chunk when it has room
+		*/
+		void append(const void* _data, size_type _len)
+		{
+			auto _at = static_cast<const std::byte*>(_data);
+			this->bytes_ += _len;
+			while (_len != 0)
+			{
+				if (this->entries_.empty() || this->entries_.back().shared || this->entries_.back().owned.size() >= send_chunk_size_v)
+				{
+					auto& _entry = this->entries_.emplace_back();
+					_entry.owned = std::exchange(this->spare_, {});
+					_entry.owned.clear();
+					_entry.owned.reserve(send_chunk_size_v);
+				};
+
+				auto& _chunk = this->entries_.back().owned;
+				const auto _count = std::min(_len, send_chunk_size_v - _chunk.size());
+				_chunk.insert(_chunk.end(), _at, _at + _count);
+				_at += _count;
+				_len -= _count;
+			};
+		};
+
+		/**
+		 * @brief Queues a shared buffer by reference, the bytes are never copied
+		*/
+		void append(SharedBuffer _buffer)
+		{
+			if (_buffer.size() == 0)
+			{
+				return;
+			};
+			this->bytes_ += _buffer.size();
+			auto& _entry = this->entries_.emplace_back();
+			_entry.shared = std::move(_buffer);
+		};
+
+		/**
+		 * @brief Marks bytes from the front of the queue as sent
+		 * @param _count Number of bytes sent, at most size()
+		*/
+		void consume(size_type _count) noexcept
+		{
+			JCLIB_ASSERT(_count <= this->bytes_);
+			this->bytes_ -= _count;
+			while (_count != 0)
+			{
+				auto& _front = this->entries_.front();
+				const auto _take = std::min(_count, _front.size() - _front.offset);
+				_front.offset += _take;
+				_count -= _take;
+				if (_front.offset == _front.size())
+				{
+					this->pop_front();
+				};
+			};
+		};
+
+		/**
+		 * @brief Sends as much of the queue as the socket accepts with one system call
+		 * @return Number of bytes sent, ERR_WOULDBLOCK if the send buffer is full on a non-blocking socket
+		*/
+		Result<size_t> flush(socket_t _sock) noexcept
+		{
+			return this->flush(_sock, this->bytes_);
+		};
+
+		/**
+		 * @brief Sends at most the given number of bytes from the queue with one system call, used for pacing
+		 * @return Number of bytes sent, ERR_WOULDBLOCK if the send buffer is full on a non-blocking socket
+		*/
+		Result<size_t> flush(socket_t _sock, size_type _limit) noexcept
+		{
+			_limit = std::min(_limit, this->bytes_);
+			if (_limit == 0)
+			{
+				return size_t{ 0 };
+			};
+
+#ifdef CCAP_NET_UNIX
+			::iovec _iov[max_iov_v];
+			size_type _count = 0;
+			for (auto& v : this->entries_)
+			{
+				if (_count == max_iov_v || _limit == 0)
+				{
+					break;
+				};
+				const auto _len = std::min(v.size() - v.offset, _limit);
+				_iov[_count].iov_base = const_cast<std::byte*>(v.data() + v.offset);
+				_iov[_count].iov_len = _len;
+				_limit -= _len;
+				++_count;
+			};
+
+			::msghdr _msg{};
+			_msg.msg_iov = _iov;
+			_msg.msg_iovlen = _count;
+
+			const auto _result = ::sendmsg(_sock, &_msg, impl::send_flags_v);
+			if (_result == sockerr)
+			{
+				return get_error();
+			};
+			const auto _sent = static_cast<size_t>(_result);
+#else
+			auto& _front = this->entries_.front();
+			const auto _result = send(_sock, _front.data() + _front.offset, std::min(_front.size() - _front.offset, _limit));
+			if (!_result)
+			{
+				return _result;
+			};
+			const auto _sent = *_result;
+#endif
+			this->consume(_sent);
+			return _sent;
+		};
+
+		/**
+		 * @brief Drops everything queued
+		*/
+		void clear() noexcept
+		{
+			this->entries_.clear();
+			this->bytes_ = 0;
+		};
+
+		SendQueue() = default;
+
+	private:
+		struct entry
+		{
+			const std::byte* data() const noexcept
+			{
+				return (this->shared) ? this->shared.data() : this->owned.data();
+			};
+			size_type size() const noexcept
+			{
+				return (this->shared) ? this->shared.size() : this->owned.size();
+			};
+
+			SharedBuffer shared{};
+			std::vector<std::byte> owned{};
+			size_type offset = 0;
+		};
+
+		void pop_front() noexcept
+		{
+			auto& _front = this->entries_.front();
+			if (!_front.shared && _front.owned.capacity() >= send_chunk_size_v)
+			{
+				// Keep one chunk around so steady small writes stop allocating
+				this->spare_ = std::move(_front.owned);
+			};
+			this->entries_.pop_front();
+		};
+
+		std::deque<entry> entries_{};
+		std::vector<std::byte> spare_{};
+		size_type bytes_ = 0;
+	};
+
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+/*
+	Immutable reference counted byte buffers for sending one payload to many sockets.
+
+	The payload is written once when the buffer is created and is read only from then on, so any number
+	of connections can queue the same bytes without copying them. Each connection holds a BufferCursor
+	with its own offset for partial writes, and the memory is freed as soon as the last cursor finishes.
+	The count and the bytes share a single allocation.
+
+		auto _payload = SharedBuffer::copy(_message.data(), _message.size());
+		for (auto& v : _subscribers)
+		{
+			v.pending.push_back(BufferCursor{ _payload });
+		};
+*/
+
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+
+#include <jclib/exception.h>
+
+#include <new>
+#include <span>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <concepts>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Read only bytes shared between any number of owners, safe to copy between threads
+	*/
+	struct SharedBuffer
+	{
+	public:
+		using size_type = size_t;
+
+		const std::byte* data() const noexcept
+		{
+			return (this->block_) ? reinterpret_cast<const std::byte*>(this->block_ + 1) : nullptr;
+		};
+		size_type size() const noexcept
+		{
+			return (this->block_) ? this->block_->size : 0;
+		};
+		std::span<const std::byte> span() const noexcept
+		{
+			return { this->data(), this->size() };
+		};
+
+		/**
+		 * @brief Number of owners sharing the bytes, approximate while other threads copy or release it
+		*/
+		size_type use_count() const noexcept
+		{
+			return (this->block_) ? this->block_->refs.load(std::memory_order_relaxed) : 0;
+		};
+
+		bool good() const noexcept
+		{
+			return this->block_ != nullptr;
+		};
+		explicit operator bool() const noexcept
+		{
+			return this->good();
+		};
+
+		/**
+		 * @brief Drops this owner's reference, freeing the bytes if it was the last one
+		*/
+		void reset() noexcept
+		{
+			if (this->block_ && this->block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				this->block_->~header();
+				::operator delete(this->block_);
+			};
+			this->block_ = nullptr;
+		};
+
+		/**
+		 * @brief Allocates a buffer and lets the caller write the payload before it is shared
+		 * @param _size Payload size in bytes
+		 * @param _fill Called once with the writable payload span
+		*/
+		template <std::invocable<std::span<std::byte>> OpT>
+		static SharedBuffer allocate(size_type _size, OpT&& _fill)
+		{
+			auto _block = ::new (::operator new(sizeof(header) + _size)) header{ _size };
+			SharedBuffer _out{ _block };
+			std::forward<OpT>(_fill)(std::span<std::byte>{ reinterpret_cast<std::byte*>(_block + 1), _size });
+			return _out;
+		};
+
+		/**
+		 * @brief Allocates a buffer holding a copy of the given bytes
+		*/
+		static SharedBuffer copy(const void* _data, size_type _len)
+		{
+			return allocate(_len, [_data](std::span<std::byte> _dest)
+				{
+					std::memcpy(_dest.data(), _data, _dest.size());
+				});
+		};
+
+		SharedBuffer() noexcept = default;
+
+		SharedBuffer(const SharedBuffer& other) noexcept :
+			block_{ other.block_ }
+		{
+			if (this->block_)
+			{
+				this->block_->refs.fetch_add(1, std::memory_order_relaxed);
+			};
+		};
+		SharedBuffer& operator=(const SharedBuffer& other) noexcept
+		{
+			SharedBuffer _copy{ other };
+			std::swap(this->block_, _copy.block_);
+			return *this;
+		};
+
+		SharedBuffer(SharedBuffer&& other) noexcept :
+			block_{ std::exchange(other.block_, nullptr) }
+		{};
+		SharedBuffer& operator=(SharedBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				this->reset();
+				this->block_ = std::exchange(other.block_, nullptr);
+			};
+			return *this;
+		};
+
+		~SharedBuffer()
+		{
+			this->reset();
+		};
+
+	private:
+		struct alignas(std::max_align_t) header
+		{
+			explicit header(size_type _size) noexcept :
+				size{ _size }
+			{};
+
+			std::atomic<size_type> refs{ 1 };
+			size_type size;
+		};
+
+		explicit SharedBuffer(header* _block) noexcept :
+			block_{ _block }
+		{};
+
+		header* block_ = nullptr;
+	};
+
+	/**
+	 * @brief One connection's position in a shared buffer, tracks how much of it has been written
+	*/
+	struct BufferCursor
+	{
+	public:
+		using size_type = size_t;
+
+		/**
+		 * @brief Bytes not yet written
+		*/
+		const std::byte* data() const noexcept
+		{
+			return this->buffer_.data() + this->offset_;
+		};
+		size_type remaining() const noexcept
+		{
+			return this->buffer_.size() - this->offset_;
+		};
+		size_type offset() const noexcept
+		{
+			return this->offset_;
+		};
+
+		/**
+		 * @brief True once every byte has been written
+		*/
+		bool done() const noexcept
+		{
+			return this->remaining() == 0;
+		};
+
+		const SharedBuffer& buffer() const noexcept
+		{
+			return this->buffer_;
+		};
+
+		/**
+		 * @brief Marks bytes as written, the buffer reference is dropped once the end is reached
+		 * @param _count Number of bytes written, at most remaining()
+		*/
+		void advance(size_type _count) noexcept
+		{
+			JCLIB_ASSERT(_count <= this->remaining());
+			this->offset_ += _count;
+			if (this->done())
+			{
+				this->buffer_.reset();
+				this->offset_ = 0;
+			};
+		};
+
+		BufferCursor() noexcept = default;
+		explicit BufferCursor(SharedBuffer _buffer, size_type _offset = 0) noexcept :
+			buffer_{ std::move(_buffer) }, offset_{ _offset }
+		{
+			JCLIB_ASSERT(this->offset_ <= this->buffer_.size());
+		};
+
+	private:
+		SharedBuffer buffer_{};
+		size_type offset_ = 0;
+	};
+
+	/**
+	 * @brief Sends as much of a shared buffer as the socket accepts and advances the cursor past it
+	 * @return Number of bytes sent, otherwise the socket error
+	*/
+	inline Result<size_t> send(socket_t _sock, BufferCursor& _cursor, int _flags = 0) noexcept
+	{
+		const auto _result = send(_sock, _cursor.data(), _cursor.remaining(), _flags);
+		if (_result)
+		{
+			_cursor.advance(*_result);
+		};
+		return _result;
+	};
+
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+/*
+	Admission control for listening sockets.
+
+	Once a server saturates, connections left in the kernel's accept queue only wait to time out. An
+	AdmissionController sits on the accept path and turns new connections away as soon as the server is
+	over budget, so clients fail fast and retry elsewhere while the connections already admitted keep
+	their latency. The budget is a cap on concurrent connections, a token bucket on the accept rate and
+	a ceiling on the loop's lag. When over budget the controller either pauses, leaving the connections
+	queued in the kernel until there is room, or accepts and resets them at once.
+
+		AdmissionController _admission{ AdmissionConfig{ .max_connections = 10'000, .accept_rate = 2'000 }, _doorbell };
+
+		// Each loop iteration, the doorbell wakes the loop when release() frees capacity
+		_admission.observe_lag(_wokeAt - _deadline);
+		_pollset.modify(_listener, _admission.admitting() ? PollSet::read : 0);
+		const auto _timeout = _admission.admitting() ? _nextTimer : std::min(_nextTimer, _admission.retry_delay());
+
+		// On a readable listener
+		while (true)
+		{
+			auto _sock = _admission.accept(_listener);
+			if (_sock) { ...; continue; }
+			if (_sock.error() != ERR_CONNREFUSED) break;
+		};
+
+		// When an admitted connection closes, from any thread
+		_admission.release();
+*/
+
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+#include <cnet/loop/Pacing.h>
+#include <cnet/loop/Doorbell.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+namespace ccap::net
+{
+	/**
+	 * @brief What an AdmissionController does with connections arriving while it is over budget
+	*/
+	enum class ShedPolicy : uint8_t
+	{
+		// Stop accepting, connections wait in the kernel queue until there is room or the backlog fills.
+		pause,
+
+		// Accept and immediately close with a reset so the client fails fast.
+		reset
+	};
+
+	/**
+	 * @brief Budget enforced by an AdmissionController, zero disables a limit
+	*/
+	struct AdmissionConfig
+	{
+		// Largest number of admitted connections open at once.
+		size_t max_connections = 0;
+
+		// Accepted connections per second.
+		uint64_t accept_rate = 0;
+
+		// Connections which may be accepted at once after an idle period.
+		uint64_t accept_burst = 64;
+
+		// Smoothed loop lag above which new connections are shed.
+		std::chrono::microseconds max_loop_lag{ 0 };
+
+		// How long a paused listener waits before checking capacity and lag again, at least 1ms.
+		std::chrono::milliseconds recheck_interval{ 10 };
+
+		ShedPolicy policy = ShedPolicy::reset;
+	};
+
+	/**
+	 * @brief Counters exported by an AdmissionController
+	*/
+	struct AdmissionStats
+	{
+		// Connections admitted.
+		uint64_t accepted = 0;
+
+		// Connections shed, split by the limit that was exceeded.
+		uint64_t shed_capacity = 0;
+		uint64_t shed_rate = 0;
+		uint64_t shed_lag = 0;
+
+		// Accept calls refused while paused.
+		uint64_t paused = 0;
+
+		// Admitted connections currently open.
+		uint64_t active = 0;
+
+		uint64_t shed() const noexcept
+		{
+			return this->shed_capacity + this->shed_rate + this->shed_lag;
+		};
+	};
+
+	/**
+	 * @brief Decides whether new connections are admitted.
+		accept() and observe_lag() belong to the listener's loop, release() and stats() may be called from any thread.
+	*/
+	struct AdmissionController
+	{
+	public:
+		using clock = TokenBucket::clock;
+		using time_point = TokenBucket::time_point;
+
+		/**
+		 * @brief Called by release() when it brings the controller back under max_connections, runs on the releasing thread
+		*/
+		using wake_function = void(*)(const void* _context) noexcept;
+
+		/**
+		 * @brief Reasons a connection can be refused
+		*/
+		enum class verdict : uint8_t
+		{
+			admit,
+			over_capacity,
+			over_rate,
+			over_lag
+		};
+
+		const AdmissionConfig& config() const noexcept
+		{
+			return this->config_;
+		};
+
+		/**
+		 * @brief Feeds one loop iteration's lag, how late the loop woke compared to when it meant to
+		*/
+		void observe_lag(std::chrono::microseconds _lag) noexcept
+		{
+			// Exponentially weighted average over roughly the last 8 iterations, kept scaled by 8
+			const auto _sample = std::max<int64_t>(_lag.count(), 0);
+			this->lag_us8_ += _sample - this->lag_us8_ / 8;
+		};
+
+		/**
+		 * @brief Smoothed loop lag
+		*/
+		std::chrono::microseconds loop_lag() const noexcept
+		{
+			return std::chrono::microseconds{ this->lag_us8_ / 8 };
+		};
+
+		/**
+		 * @brief Checks the budget without accepting anything
+		*/
+		verdict check(time_point _now = clock::now()) noexcept
+		{
+			if (this->config_.max_connections != 0 && this->active_.load(std::memory_order_relaxed) >= this->config_.max_connections)
+			{
+				return verdict::over_capacity;
+			};
+			if (this->config_.max_loop_lag.count() != 0 && this->loop_lag() > this->config_.max_loop_lag)
+			{
+				return verdict::over_lag;
+			};
+			if (this->rate_.available(_now) == 0)
+			{
+				return verdict::over_rate;
+			};
+			return verdict::admit;
+		};
+
+		/**
+		 * @brief True if the listener should be polled for new connections.
+			Always true with ShedPolicy::reset, which has to accept connections to turn them away.
+		*/
+		bool admitting(time_point _now = clock::now()) noexcept
+		{
+			return this->config_.policy == ShedPolicy::reset || this->check(_now) == verdict::admit;
+		};
+
+		/**
+		 * @brief Time until the budget should be checked again, use it as the listener's timer while paused.
+			Zero when admitting, the time until the next rate token when over the accept rate, otherwise
+			recheck_interval as capacity only frees up through release() and the lag only decays as the loop runs.
+		*/
+		TokenBucket::duration retry_delay(time_point _now = clock::now()) noexcept
+		{
+			switch (this->check(_now))
+			{
+			case verdict::admit:
+				return TokenBucket::duration::zero();
+			case verdict::over_rate:
+				return this->rate_.delay(_now, 1);
+			default:
+				return std::max<TokenBucket::duration>(this->config_.recheck_interval, std::chrono::milliseconds{ 1 });
+			};
+		};
+
+		/**
+		 * @brief Accepts one connection if the budget allows it
+		 * @return The admitted socket. ERR_CONNREFUSED if a connection was shed, keep accepting.
+			ERR_WOULDBLOCK if none are pending or the controller is paused, stop until the next readiness or timer.
+		*/
+		Result<socket_t> accept(socket_t _listener, time_point _now = clock::now()) noexcept
+		{
+			const auto _verdict = this->check(_now);
+			if (_verdict != verdict::admit && this->config_.policy == ShedPolicy::pause)
+			{
+				this->paused_.fetch_add(1, std::memory_order_relaxed);
+				return ERR_WOULDBLOCK;
+			};
+
+			auto _sock = net::accept(_listener);
+			if (!_sock)
+			{
+				return _sock;
+			};
+
+			if (_verdict != verdict::admit)
+			{
+				close_with_reset(*_sock);
+				this->count_shed(_verdict);
+				return ERR_CONNREFUSED;
+			};
+
+			this->rate_.consume(1);
+			this->active_.fetch_add(1, std::memory_order_relaxed);
+			this->accepted_.fetch_add(1, std::memory_order_relaxed);
+			return _sock;
+		};
+
+		/**
+		 * @brief Records that an admitted connection has closed, safe to call from any thread.
+			Calls the wake function if this brings the controller back under max_connections.
+		*/
+		void release() noexcept
+		{
+			const auto _previous = this->active_.fetch_sub(1, std::memory_order_relaxed);
+			JCLIB_ASSERT(_previous != 0);
+			if (this->wake_ && _previous == this->config_.max_connections)
+			{
+				this->wake_(this->wake_context_);
+			};
+		};
+
+		/**
+		 * @brief Snapshot of the counters, safe to call from any thread
+		*/
+		AdmissionStats stats() const noexcept
+		{
+			AdmissionStats _out{};
+			_out.accepted = this->accepted_.load(std::memory_order_relaxed);
+			_out.shed_capacity = this->shed_capacity_.load(std::memory_order_relaxed);
+			_out.shed_rate = this->shed_rate_.load(std::memory_order_relaxed);
+			_out.shed_lag = this->shed_lag_.load(std::memory_order_relaxed);
+			_out.paused = this->paused_.load(std::memory_order_relaxed);
+			_out.active = this->active_.load(std::memory_order_relaxed);
+			return _out;
+		};
+
+		/**
+		 * @param _wake Called when release() frees capacity so a paused loop can resume, nullptr for none
+		 * @param _context Passed to _wake
+		*/
+		explicit AdmissionController(AdmissionConfig _config = {}, wake_function _wake = nullptr, const void* _context = nullptr) noexcept :
+			config_{ _config }, rate_{ _config.accept_rate, _config.accept_burst }, wake_{ _wake }, wake_context_{ _context }
+		{};
+
+#ifdef CCAP_NET_UNIX
+		/**
+		 * @brief Rings the given doorbell whenever release() frees capacity
+		 * @param _doorbell Doorbell the listener's loop waits on, must outlive the controller
+		*/
+		AdmissionController(AdmissionConfig _config, const Doorbell& _doorbell) noexcept :
+			AdmissionController{ _config, [](const void* _context) noexcept { static_cast<const Doorbell*>(_context)->ring(); }, &_doorbell }
+		{};
+#endif
+
+		AdmissionController(const AdmissionController&) = delete;
+		AdmissionController& operator=(const AdmissionController&) = delete;
+
+	private:
+		void count_shed(verdict _verdict) noexcept
+		{
+			switch (_verdict)
+			{
+			case verdict::over_capacity:
+				this->shed_capacity_.fetch_add(1, std::memory_order_relaxed);
+				break;
+			case verdict::over_rate:
+				this->shed_rate_.fetch_add(1, std::memory_order_relaxed);
+				break;
+			case verdict::over_lag:
+				this->shed_lag_.fetch_add(1, std::memory_order_relaxed);
+				break;
+			default:
+				break;
+			};
+		};
+
+		AdmissionConfig config_;
+		TokenBucket rate_;
+		wake_function wake_ = nullptr;
+		const void* wake_context_ = nullptr;
+		int64_t lag_us8_ = 0;
+
+		std::atomic<uint64_t> active_{ 0 };
+		std::atomic<uint64_t> accepted_{ 0 };
+		std::atomic<uint64_t> shed_capacity_{ 0 };
+		std::atomic<uint64_t> shed_rate_{ 0 };
+		std::atomic<uint64_t> shed_lag_{ 0 };
+		std::atomic<uint64_t> paused_{ 0 };
+	};
+
+};
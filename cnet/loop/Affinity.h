@@ -0,0 +1,392 @@
+#pragma once
+
+/*
+	CPU and NUMA placement for I/O loops.
+
+	Loop threads are pinned with pin_current_thread(), per-loop buffers come from NodeBuffer so their
+	pages live on the loop's NUMA node, and CpuRouter uses SO_INCOMING_CPU to hand each accepted socket
+	to the loop running on the core that already processes its packets.
+
+	Only available on Linux.
+*/
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
+#include <cnet/socket/SocketOption.h>
+
+#if defined(CCAP_NET_UNIX) && defined(__linux__)
+
+#include <span>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <climits>
+#include <initializer_list>
+#include <utility>
+#include <algorithm>
+
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Set of CPUs a thread may run on
+	*/
+	struct CpuSet
+	{
+	public:
+		/**
+		 * @brief Number of CPUs representable in the set
+		*/
+		constexpr static int capacity() noexcept
+		{
+			return CPU_SETSIZE;
+		};
+
+		void insert(int _cpu) noexcept
+		{
+			JCLIB_ASSERT(_cpu >= 0 && _cpu < capacity());
+			CPU_SET(_cpu, &this->set_);
+		};
+		void erase(int _cpu) noexcept
+		{
+			JCLIB_ASSERT(_cpu >= 0 && _cpu < capacity());
+			CPU_CLR(_cpu, &this->set_);
+		};
+		bool contains(int _cpu) const noexcept
+		{
+			return _cpu >= 0 && _cpu < capacity() && CPU_ISSET(_cpu, &this->set_);
+		};
+		int size() const noexcept
+		{
+			return CPU_COUNT(&this->set_);
+		};
+		bool empty() const noexcept
+		{
+			return this->size() == 0;
+		};
+		void clear() noexcept
+		{
+			CPU_ZERO(&this->set_);
+		};
+
+		/**
+		 * @brief Calls the given function with each CPU in the set in ascending order
+		*/
+		template <typename OpT>
+		void for_each(OpT&& _op) const
+		{
+			for (int n = 0, _left = this->size(); _left != 0; ++n)
+			{
+				if (CPU_ISSET(n, &this->set_))
+				{
+					_op(n);
+					--_left;
+				};
+			};
+		};
+
+		const ::cpu_set_t& native() const noexcept
+		{
+			return this->set_;
+		};
+		::cpu_set_t& native() noexcept
+		{
+			return this->set_;
+		};
+
+		CpuSet() noexcept
+		{
+			this->clear();
+		};
+		CpuSet(std::initializer_list<int> _cpus) noexcept :
+			CpuSet{}
+		{
+			for (auto& v : _cpus)
+			{
+				this->insert(v);
+			};
+		};
+
+	private:
+		::cpu_set_t set_;
+	};
+
+	/**
+	 * @brief Restricts the calling thread to the given CPUs
+	 * @return Empty result on success, otherwise the error
+	*/
+	inline Result<void> pin_current_thread(const CpuSet& _cpus) noexcept
+	{
+		const auto _result = ::pthread_setaffinity_np(::pthread_self(), sizeof(::cpu_set_t), &_cpus.native());
+		if (_result != 0)
+		{
+			return SocketError{ _result };
+		};
+		return {};
+	};
+
+	/**
+	 * @brief Returns the CPUs the calling thread may currently run on
+	*/
+	inline Result<CpuSet> current_thread_affinity() noexcept
+	{
+		CpuSet _out{};
+		const auto _result = ::pthread_getaffinity_np(::pthread_self(), sizeof(::cpu_set_t), &_out.native());
+		if (_result != 0)
+		{
+			return SocketError{ _result };
+		};
+		return _out;
+	};
+
+	/**
+	 * @brief Returns the CPU the calling thread is running on right now
+	*/
+	inline Result<int> current_cpu() noexcept
+	{
+		const auto _cpu = ::sched_getcpu();
+		if (_cpu < 0)
+		{
+			return get_error();
+		};
+		return _cpu;
+	};
+
+	/**
+	 * @brief Looks up the NUMA node a CPU belongs to
+	 * @return The node, 0 on machines which do not expose NUMA topology
+	*/
+	inline int numa_node_of_cpu(int _cpu) noexcept
+	{
+		char _path[64]{};
+		std::snprintf(_path, sizeof(_path), "/sys/devices/system/cpu/cpu%d", _cpu);
+
+		auto _dir = ::opendir(_path);
+		if (!_dir)
+		{
+			return 0;
+		};
+
+		int _node = 0;
+		while (auto _entry = ::readdir(_dir))
+		{
+			if (std::sscanf(_entry->d_name, "node%d", &_node) == 1)
+			{
+				break;
+			};
+		};
+		::closedir(_dir);
+		return _node;
+	};
+
+	/**
+	 * @brief Reads the CPU whose softirq processed the socket's most recent packets
+	 * @return The CPU, otherwise the socket error
+	*/
+	inline Result<int> get_incoming_cpu(socket_t _sock) noexcept
+	{
+		return get_option<incoming_cpu>(_sock);
+	};
+
+
+
+	/**
+	 * @brief Page aligned buffer whose memory is placed on a chosen NUMA node.
+
+		The memory is bound to the node with mbind where the kernel allows it and is always prefaulted,
+		so allocating from a thread pinned to the node places it correctly through first touch even
+		when mbind is unavailable.
+	*/
+	struct NodeBuffer
+	{
+	public:
+		std::byte* data() const noexcept
+		{
+			return this->data_;
+		};
+		size_t size() const noexcept
+		{
+			return this->size_;
+		};
+		std::span<std::byte> span() const noexcept
+		{
+			return { this->data_, this->size_ };
+		};
+
+		bool good() const noexcept
+		{
+			return this->data_ != nullptr;
+		};
+		explicit operator bool() const noexcept
+		{
+			return this->good();
+		};
+
+		void release() noexcept
+		{
+			this->data_ = nullptr;
+			this->size_ = 0;
+		};
+		void reset() noexcept
+		{
+			if (this->good())
+			{
+				::munmap(this->data_, this->size_);
+				this->release();
+			};
+		};
+
+		/**
+		 * @brief Allocates a buffer on the given NUMA node
+		 * @param _bytes Size in bytes, rounded up to whole pages
+		 * @param _node NUMA node, see numa_node_of_cpu
+		 * @return The buffer, otherwise the allocation error
+		*/
+		static Result<NodeBuffer> allocate(size_t _bytes, int _node) noexcept
+		{
+			const auto _page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+			_bytes = (_bytes + _page - 1) / _page * _page;
+
+			auto _data = ::mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (_data == MAP_FAILED)
+			{
+				return get_error();
+			};
+
+#ifdef SYS_mbind
+			if (_node >= 0 && _node < 64)
+			{
+				// MPOL_PREFERRED, falls back to other nodes rather than failing when the node is full
+				constexpr int _preferred = 1;
+				const unsigned long _mask = 1UL << _node;
+				::syscall(SYS_mbind, _data, _bytes, _preferred, &_mask, sizeof(_mask) * CHAR_BIT, 0);
+			};
+#endif
+
+			// Fault every page in now so placement happens here and not on the hot path
+			for (size_t n = 0; n < _bytes; n += _page)
+			{
+				static_cast<volatile std::byte*>(_data)[n] = std::byte{};
+			};
+
+			return NodeBuffer{ static_cast<std::byte*>(_data), _bytes };
+		};
+
+		NodeBuffer() noexcept = default;
+
+		NodeBuffer(const NodeBuffer&) = delete;
+		NodeBuffer& operator=(const NodeBuffer&) = delete;
+
+		NodeBuffer(NodeBuffer&& other) noexcept :
+			data_{ std::exchange(other.data_, nullptr) },
+			size_{ std::exchange(other.size_, 0) }
+		{};
+		NodeBuffer& operator=(NodeBuffer&& other) noexcept
+		{
+			this->reset();
+			this->data_ = std::exchange(other.data_, nullptr);
+			this->size_ = std::exchange(other.size_, 0);
+			return *this;
+		};
+
+		~NodeBuffer()
+		{
+			this->reset();
+		};
+
+	private:
+		NodeBuffer(std::byte* _data, size_t _size) noexcept :
+			data_{ _data }, size_{ _size }
+		{};
+
+		std::byte* data_ = nullptr;
+		size_t size_ = 0;
+	};
+
+
+
+	/**
+	 * @brief Picks the loop an accepted socket should be handed to based on SO_INCOMING_CPU.
+
+		Each loop is described by the CPUs its thread is pinned to, a socket goes to the loop pinned to
+		the CPU that handles its packets. Sockets whose CPU no loop covers, or whose CPU cannot be read,
+		are spread round-robin.
+	*/
+	struct CpuRouter
+	{
+	public:
+		using size_type = size_t;
+
+		/**
+		 * @brief Number of loops being routed between
+		*/
+		size_type size() const noexcept
+		{
+			return this->loops_;
+		};
+
+		/**
+		 * @brief Returns the loop index for a CPU
+		*/
+		size_type route(int _cpu) noexcept
+		{
+			if (_cpu >= 0 && static_cast<size_type>(_cpu) < this->table_.size())
+			{
+				const auto _loop = this->table_[_cpu];
+				if (_loop >= 0)
+				{
+					return static_cast<size_type>(_loop);
+				};
+			};
+			return this->next_.fetch_add(1, std::memory_order_relaxed) % this->loops_;
+		};
+
+		/**
+		 * @brief Returns the loop index for an accepted socket
+		*/
+		size_type route_socket(socket_t _sock) noexcept
+		{
+			return this->route(get_incoming_cpu(_sock).value_or(-1));
+		};
+
+		/**
+		 * @brief Creates a router
+		 * @param _loops CPUs each loop is pinned to, indexed by loop
+		*/
+		explicit CpuRouter(std::span<const CpuSet> _loops) :
+			loops_{ std::max<size_type>(_loops.size(), 1) }
+		{
+			for (size_type n = 0; n != _loops.size(); ++n)
+			{
+				_loops[n].for_each([this, n](int _cpu)
+				{
+					if (static_cast<size_type>(_cpu) >= this->table_.size())
+					{
+						this->table_.resize(_cpu + 1, -1);
+					};
+					if (this->table_[_cpu] < 0)
+					{
+						this->table_[_cpu] = static_cast<int>(n);
+					};
+				});
+			};
+		};
+
+	private:
+		std::vector<int> table_{};
+		size_type loops_;
+		std::atomic<size_type> next_{ 0 };
+	};
+
+};
+
+#endif
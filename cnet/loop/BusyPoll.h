@@ -0,0 +1,216 @@
+#pragma once
+
+/*
+	Adaptive busy-poll waiting for latency critical loops.
+
+	Instead of blocking straight away, wait() spins on zero-timeout readiness checks for a spin budget
+	and only then falls back to a blocking wait. The budget adapts: it grows while spinning keeps finding
+	work and shrinks each time the spin runs dry, so an idle loop quickly settles into plain blocking and
+	stops burning a core. Pair it with busy_poll and prefer_busy_poll on the sockets, see socket_options(),
+	so the kernel also polls the device queue instead of waiting on interrupts.
+*/
+
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketOption.h>
+
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <concepts>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ccap::net
+{
+	namespace impl
+	{
+		/**
+		 * @brief Hints to the CPU that the thread is spinning
+		*/
+		inline void cpu_relax() noexcept
+		{
+#if defined(_MSC_VER)
+			_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+			asm volatile("yield");
+#endif
+		};
+	};
+
+	/**
+	 * @brief Satisfied by readiness sets with a poll(timeout) function, such as PollSet
+	*/
+	template <typename T>
+	concept cx_poller = requires(T & _poller, std::chrono::milliseconds _timeout)
+	{
+		{ _poller.poll(_timeout) } -> std::same_as<Result<int>>;
+	};
+
+	/**
+	 * @brief Busy poll tuning
+	*/
+	struct BusyPollConfig
+	{
+		// Spin budget used for the first wait.
+		std::chrono::microseconds initial_spin{ 50 };
+
+		// Budget never shrinks below this, zero allows falling back to pure blocking.
+		std::chrono::microseconds min_spin{ 0 };
+
+		// Budget never grows beyond this.
+		std::chrono::microseconds max_spin{ 200 };
+
+		// Value for SO_BUSY_POLL on sockets served by the loop, see BusyPoller::socket_options().
+		std::chrono::microseconds socket_busy_poll{ 50 };
+	};
+
+	/**
+	 * @brief Counters describing how waits were satisfied
+	*/
+	struct BusyPollStats
+	{
+		// Waits satisfied while spinning.
+		uint64_t spin_hits = 0;
+
+		// Waits which exhausted the spin budget and blocked.
+		uint64_t sleeps = 0;
+
+		// Zero-timeout readiness checks made while spinning.
+		uint64_t spin_polls = 0;
+
+		// Total time spent spinning.
+		std::chrono::nanoseconds spin_time{ 0 };
+
+		// Total time spent blocked.
+		std::chrono::nanoseconds sleep_time{ 0 };
+	};
+
+	/**
+	 * @brief Waits on a poller by spinning for an adaptive budget before blocking
+	*/
+	struct BusyPoller
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		const BusyPollConfig& config() const noexcept
+		{
+			return this->config_;
+		};
+		const BusyPollStats& stats() const noexcept
+		{
+			return this->stats_;
+		};
+		void reset_stats() noexcept
+		{
+			this->stats_ = BusyPollStats{};
+		};
+
+		/**
+		 * @brief Current spin budget
+		*/
+		std::chrono::microseconds spin_budget() const noexcept
+		{
+			return this->budget_;
+		};
+
+		/**
+		 * @brief Socket options to apply to sockets served by this loop
+		*/
+		auto socket_options() const noexcept
+		{
+			return make_options(busy_poll{ this->config_.socket_busy_poll }, prefer_busy_poll{ true });
+		};
+
+		/**
+		 * @brief Waits until the poller reports readiness or the timeout expires
+		 * @param _poller Poller to wait on, such as a PollSet
+		 * @param _timeout Maximum time to wait including the spin, negative waits indefinitely
+		 * @return Number of ready sockets, 0 on timeout, otherwise the poller's error
+		*/
+		template <cx_poller PollerT>
+		Result<int> wait(PollerT& _poller, std::chrono::milliseconds _timeout = std::chrono::milliseconds{ -1 })
+		{
+			const auto _start = clock::now();
+			const auto _spinEnd = _start + std::min<clock::duration>(this->budget_,
+				(_timeout.count() < 0) ? clock::duration::max() : clock::duration{ _timeout });
+
+			// Spin phase
+			auto _now = _start;
+			while (_now < _spinEnd)
+			{
+				auto _result = _poller.poll(std::chrono::milliseconds{ 0 });
+				++this->stats_.spin_polls;
+				if (!_result || *_result != 0)
+				{
+					_now = clock::now();
+					this->stats_.spin_time += _now - _start;
+					if (_result)
+					{
+						++this->stats_.spin_hits;
+						this->grow(this->budget_);
+					};
+					return _result;
+				};
+				impl::cpu_relax();
+				_now = clock::now();
+			};
+			this->stats_.spin_time += _now - _start;
+
+			// Spin ran dry, block for whatever remains of the timeout
+			++this->stats_.sleeps;
+
+			auto _remaining = _timeout;
+			if (_timeout.count() >= 0)
+			{
+				const auto _spent = std::chrono::duration_cast<std::chrono::milliseconds>(_now - _start);
+				_remaining = std::max(_timeout - _spent, std::chrono::milliseconds{ 0 });
+			};
+			auto _result = _poller.poll(_remaining);
+
+			// Work which arrived shortly after blocking would have been caught by a longer spin
+			const auto _slept = clock::now() - _now;
+			this->stats_.sleep_time += _slept;
+			if (_result && *_result != 0 && _slept <= this->config_.max_spin)
+			{
+				this->grow(std::chrono::ceil<std::chrono::microseconds>(_slept));
+			}
+			else
+			{
+				this->shrink();
+			};
+			return _result;
+		};
+
+		explicit BusyPoller(BusyPollConfig _config) noexcept :
+			config_{ _config },
+			budget_{ std::clamp(_config.initial_spin, _config.min_spin, _config.max_spin) }
+		{};
+		BusyPoller() noexcept :
+			BusyPoller{ BusyPollConfig{} }
+		{};
+
+	private:
+		/**
+		 * @brief Doubles the budget, or raises it to cover the given wait if that is larger
+		*/
+		void grow(std::chrono::microseconds _atLeast) noexcept
+		{
+			const auto _next = std::max({ this->budget_ * 2, _atLeast, std::chrono::microseconds{ 1 } });
+			this->budget_ = std::min(_next, this->config_.max_spin);
+		};
+		void shrink() noexcept
+		{
+			this->budget_ = std::max(this->budget_ / 2, this->config_.min_spin);
+		};
+
+		BusyPollConfig config_;
+		BusyPollStats stats_{};
+		std::chrono::microseconds budget_;
+	};
+
+};
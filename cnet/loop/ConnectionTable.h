@@ -0,0 +1,324 @@
+#pragma once
+
+/*
+	Registry of live connections addressed by generational handles.
+
+	A handle names a slot plus the generation the slot had when the connection was inserted. Erasing a
+	connection bumps the slot's generation, so handles kept past the erase stop resolving even after the
+	slot and the descriptor have been reused. The hot fields the loop scans every iteration are kept in
+	dense parallel arrays with no holes, erase swaps the last connection into the gap. Cold per
+	connection data lives in its own dense array so scanning the hot fields never pulls it into cache.
+	After reserve() inserting and erasing never allocate.
+*/
+
+#include <cnet/socket/SocketType.h>
+
+#include <jclib/exception.h>
+
+#include <span>
+#include <limits>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include <concepts>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Stable reference to a connection in a ConnectionTable, never matches a later connection in the same slot
+	*/
+	struct ConnectionHandle
+	{
+		uint32_t index = 0;
+		uint32_t generation = 0;
+
+		/**
+		 * @brief Packs the handle into one integer, for use as user data in epoll or io_uring
+		*/
+		constexpr uint64_t pack() const noexcept
+		{
+			return (static_cast<uint64_t>(this->generation) << 32) | this->index;
+		};
+		constexpr static ConnectionHandle unpack(uint64_t _value) noexcept
+		{
+			return ConnectionHandle{ static_cast<uint32_t>(_value), static_cast<uint32_t>(_value >> 32) };
+		};
+
+		constexpr bool operator==(const ConnectionHandle&) const noexcept = default;
+	};
+
+	/**
+	 * @brief Empty cold data for tables which need none
+	*/
+	struct NoConnectionData {};
+
+	/**
+	 * @brief Connection registry with generational handles and a struct-of-arrays hot layout, not thread safe
+	 * @tparam ColdT Rarely touched per connection data, stored apart from the hot fields
+	*/
+	template <typename ColdT = NoConnectionData>
+	requires std::is_nothrow_move_constructible_v<ColdT> && std::is_nothrow_move_assignable_v<ColdT>
+	struct ConnectionTable
+	{
+	public:
+		using size_type = size_t;
+		using cold_type = ColdT;
+		using clock = std::chrono::steady_clock;
+		using time_point = typename clock::time_point;
+
+		/**
+		 * @brief Deadline value meaning the connection has none
+		*/
+		constexpr static time_point no_deadline = time_point::max();
+
+		/**
+		 * @brief Largest number of connections a table can hold
+		*/
+		constexpr static size_type max_size_v = std::numeric_limits<uint32_t>::max() - 1;
+
+		size_type size() const noexcept
+		{
+			return this->fds_.size();
+		};
+		bool empty() const noexcept
+		{
+			return this->fds_.empty();
+		};
+
+		/**
+		 * @brief Preallocates room for a number of connections so later inserts never allocate
+		*/
+		void reserve(size_type _count)
+		{
+			JCLIB_ASSERT(_count <= max_size_v);
+			this->slots_.reserve(_count);
+			this->owners_.reserve(_count);
+			this->fds_.reserve(_count);
+			this->events_.reserve(_count);
+			this->deadlines_.reserve(_count);
+			this->queued_.reserve(_count);
+			this->cold_.reserve(_count);
+		};
+
+		/**
+		 * @brief Adds a connection
+		 * @param _sock Connection socket, the table does not close it
+		 * @param _events Interest mask, usually PollSet::read
+		 * @param _cold Cold data for the connection
+		 * @return Handle for the new connection
+		*/
+		ConnectionHandle insert(socket_t _sock, short _events, cold_type _cold = {})
+		{
+			JCLIB_ASSERT(this->size() < max_size_v);
+			const auto _dense = static_cast<uint32_t>(this->fds_.size());
+
+			uint32_t _index{};
+			if (this->free_ != npos)
+			{
+				_index = this->free_;
+				this->free_ = this->slots_[_index].dense;
+			}
+			else
+			{
+				_index = static_cast<uint32_t>(this->slots_.size());
+				this->slots_.push_back(slot{ npos, 1 });
+			};
+
+			auto& _slot = this->slots_[_index];
+			_slot.dense = _dense;
+
+			this->owners_.push_back(_index);
+			this->fds_.push_back(_sock);
+			this->events_.push_back(_events);
+			this->deadlines_.push_back(no_deadline);
+			this->queued_.push_back(0);
+			this->cold_.push_back(std::move(_cold));
+
+			return ConnectionHandle{ _index, _slot.generation };
+		};
+
+		/**
+		 * @brief Removes a connection, its handle and any copies of it stop resolving
+		 * @return False if the handle was already stale
+		*/
+		bool erase(ConnectionHandle _handle) noexcept
+		{
+			const auto _found = this->find(_handle);
+			if (!_found)
+			{
+				return false;
+			};
+
+			const auto _dense = *_found;
+			const auto _last = this->size() - 1;
+			if (_dense != _last)
+			{
+				// Move the last connection into the hole so the hot arrays stay dense
+				this->slots_[this->owners_[_last]].dense = static_cast<uint32_t>(_dense);
+				this->owners_[_dense] = this->owners_[_last];
+				this->fds_[_dense] = this->fds_[_last];
+				this->events_[_dense] = this->events_[_last];
+				this->deadlines_[_dense] = this->deadlines_[_last];
+				this->queued_[_dense] = this->queued_[_last];
+				this->cold_[_dense] = std::move(this->cold_[_last]);
+			};
+
+			this->owners_.pop_back();
+			this->fds_.pop_back();
+			this->events_.pop_back();
+			this->deadlines_.pop_back();
+			this->queued_.pop_back();
+			this->cold_.pop_back();
+
+			auto& _slot = this->slots_[_handle.index];
+			_slot.dense = this->free_;
+			this->free_ = _handle.index;
+
+			// Skip generation 0 so a default handle never resolves
+			if (++_slot.generation == 0)
+			{
+				_slot.generation = 1;
+			};
+			return true;
+		};
+
+		/**
+		 * @brief Finds a connection's position in the dense arrays
+		 * @return Dense index, nullopt if the handle is stale
+		*/
+		std::optional<size_type> find(ConnectionHandle _handle) const noexcept
+		{
+			if (_handle.index >= this->slots_.size())
+			{
+				return std::nullopt;
+			};
+			const auto& _slot = this->slots_[_handle.index];
+			if (_slot.generation != _handle.generation)
+			{
+				return std::nullopt;
+			};
+			return _slot.dense;
+		};
+		bool contains(ConnectionHandle _handle) const noexcept
+		{
+			return this->find(_handle).has_value();
+		};
+
+		/**
+		 * @brief Handle of the connection at a dense index
+		*/
+		ConnectionHandle handle_at(size_type _dense) const noexcept
+		{
+			JCLIB_ASSERT(_dense < this->size());
+			const auto _index = this->owners_[_dense];
+			return ConnectionHandle{ _index, this->slots_[_index].generation };
+		};
+
+		/**
+		 * @brief Hot fields, indexed by dense index and valid until the next insert or erase
+		*/
+		std::span<socket_t> fds() noexcept
+		{
+			return this->fds_;
+		};
+		std::span<const socket_t> fds() const noexcept
+		{
+			return this->fds_;
+		};
+		std::span<short> events() noexcept
+		{
+			return this->events_;
+		};
+		std::span<const short> events() const noexcept
+		{
+			return this->events_;
+		};
+		std::span<time_point> deadlines() noexcept
+		{
+			return this->deadlines_;
+		};
+		std::span<const time_point> deadlines() const noexcept
+		{
+			return this->deadlines_;
+		};
+		std::span<size_type> queued() noexcept
+		{
+			return this->queued_;
+		};
+		std::span<const size_type> queued() const noexcept
+		{
+			return this->queued_;
+		};
+
+		/**
+		 * @brief Cold data, indexed by dense index
+		*/
+		std::span<cold_type> cold() noexcept
+		{
+			return this->cold_;
+		};
+		std::span<const cold_type> cold() const noexcept
+		{
+			return this->cold_;
+		};
+
+		/**
+		 * @brief Calls the given function with the handle of every connection whose deadline has passed.
+			The function may erase the connection it is given, but no others.
+		*/
+		template <std::invocable<ConnectionHandle> OpT>
+		void for_each_expired(time_point _now, OpT&& _op)
+		{
+			// Walk backwards so erasing the current connection only moves ones already visited
+			for (auto n = this->size(); n != 0; --n)
+			{
+				if (this->deadlines_[n - 1] <= _now)
+				{
+					_op(this->handle_at(n - 1));
+				};
+			};
+		};
+
+		/**
+		 * @brief Earliest deadline of any connection, no_deadline if none have one
+		*/
+		time_point next_deadline() const noexcept
+		{
+			auto _out = no_deadline;
+			for (auto& v : this->deadlines_)
+			{
+				_out = (v < _out) ? v : _out;
+			};
+			return _out;
+		};
+
+		ConnectionTable() = default;
+
+	private:
+		constexpr static uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+		struct slot
+		{
+			// Dense index while occupied, next free slot while free.
+			uint32_t dense;
+			uint32_t generation;
+		};
+
+		std::vector<slot> slots_{};
+		uint32_t free_ = npos;
+
+		// Hot fields
+		std::vector<uint32_t> owners_{};
+		std::vector<socket_t> fds_{};
+		std::vector<short> events_{};
+		std::vector<time_point> deadlines_{};
+		std::vector<size_type> queued_{};
+
+		// Cold fields
+		std::vector<cold_type> cold_{};
+	};
+
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+/*
+	Wakes a thread blocked in select/poll from another thread, backed by an eventfd on Linux
+	and a non-blocking pipe on other Unix targets. Only available when CCAP_NET_UNIX is defined.
+*/
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
+
+#ifdef CCAP_NET_UNIX
+
+#include <utility>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace ccap::net
+{
+	/**
+	 * @brief Descriptor which becomes readable when rung, add fd() to the waiting thread's poller
+	*/
+	struct Doorbell
+	{
+	public:
+		/**
+		 * @brief Descriptor to wait on for readability
+		*/
+		socket_t fd() const noexcept
+		{
+			return this->read_;
+		};
+
+		bool good() const noexcept
+		{
+			return this->read_ != nullsock;
+		};
+		explicit operator bool() const noexcept
+		{
+			return this->good();
+		};
+
+		/**
+		 * @brief Makes fd() readable, safe to call from any thread
+		*/
+		void ring() const noexcept
+		{
+#ifdef __linux__
+			const uint64_t _one = 1;
+			[[maybe_unused]] const auto _result = ::write(this->write_, &_one, sizeof(_one));
+#else
+			const char _one = 1;
+			[[maybe_unused]] const auto _result = ::write(this->write_, &_one, sizeof(_one));
+#endif
+		};
+
+		/**
+		 * @brief Clears the readable state, call from the waiting thread after it wakes
+		*/
+		void drain() const noexcept
+		{
+#ifdef __linux__
+			uint64_t _count{};
+			[[maybe_unused]] const auto _result = ::read(this->read_, &_count, sizeof(_count));
+#else
+			char _buffer[64];
+			while (::read(this->read_, _buffer, sizeof(_buffer)) > 0) {};
+#endif
+		};
+
+		void release() noexcept
+		{
+			this->read_ = nullsock;
+			this->write_ = nullsock;
+		};
+		void reset() noexcept
+		{
+			if (this->good())
+			{
+				close_socket(this->read_);
+				if (this->write_ != this->read_)
+				{
+					close_socket(this->write_);
+				};
+				this->release();
+			};
+		};
+
+		/**
+		 * @brief Creates a new doorbell
+		 * @return The doorbell, otherwise the error from creating the descriptor
+		*/
+		static Result<Doorbell> open() noexcept
+		{
+#ifdef __linux__
+			const auto _fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (_fd == nullsock)
+			{
+				return get_error();
+			};
+			return Doorbell{ _fd, _fd };
+#else
+			int _fds[2]{};
+			if (::pipe(_fds) == sockerr)
+			{
+				return get_error();
+			};
+			for (auto v : _fds)
+			{
+				::fcntl(v, F_SETFL, ::fcntl(v, F_GETFL, 0) | O_NONBLOCK);
+				::fcntl(v, F_SETFD, FD_CLOEXEC);
+			};
+			return Doorbell{ _fds[0], _fds[1] };
+#endif
+		};
+
+		Doorbell() noexcept = default;
+
+		Doorbell(const Doorbell&) = delete;
+		Doorbell& operator=(const Doorbell&) = delete;
+
+		Doorbell(Doorbell&& other) noexcept :
+			read_{ std::exchange(other.read_, nullsock) },
+			write_{ std::exchange(other.write_, nullsock) }
+		{};
+		Doorbell& operator=(Doorbell&& other) noexcept
+		{
+			this->reset();
+			this->read_ = std::exchange(other.read_, nullsock);
+			this->write_ = std::exchange(other.write_, nullsock);
+			return *this;
+		};
+
+		~Doorbell()
+		{
+			this->reset();
+		};
+
+	private:
+		Doorbell(socket_t _read, socket_t _write) noexcept :
+			read_{ _read }, write_{ _write }
+		{};
+
+		socket_t read_ = nullsock;
+		socket_t write_ = nullsock;
+	};
+
+};
+
+#endif
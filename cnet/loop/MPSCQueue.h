@@ -0,0 +1,146 @@
+#pragma once
+
+/*
+	Bounded lock-free multi-producer single-consumer queue.
+
+	Each cell carries a sequence number so producers claim slots with a single CAS on the tail and
+	publish with a release store, the consumer never touches the tail. Head, tail and the cell array
+	live on separate cache lines to keep producers and the consumer from false sharing.
+*/
+
+#include <jclib/exception.h>
+
+#include <bit>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Assumed cache line size used for padding shared state
+	*/
+	constexpr inline size_t cache_line_size_v = 64;
+
+	/**
+	 * @brief Bounded lock-free queue, any number of threads may push but only one may pop
+	 * @tparam T Value type, moved in and out of the queue
+	*/
+	template <typename T>
+	requires (std::is_nothrow_default_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)
+	struct MPSCQueue
+	{
+	public:
+		using value_type = T;
+		using size_type = size_t;
+
+		/**
+		 * @brief Maximum number of values the queue can hold
+		*/
+		size_type capacity() const noexcept
+		{
+			return this->mask_ + 1;
+		};
+
+		/**
+		 * @brief Approximate number of queued values, exact when called from the consumer with no producers running
+		*/
+		size_type size() const noexcept
+		{
+			const auto _tail = this->tail_.load(std::memory_order_acquire);
+			const auto _head = this->head_.load(std::memory_order_acquire);
+			return (_tail > _head) ? (_tail - _head) : 0;
+		};
+		bool empty() const noexcept
+		{
+			return this->size() == 0;
+		};
+
+		/**
+		 * @brief Pushes a value, safe to call from any thread
+		 * @return False if the queue is full
+		*/
+		bool try_push(value_type _value) noexcept
+		{
+			auto _pos = this->tail_.load(std::memory_order_relaxed);
+			cell* _cell = nullptr;
+			while (true)
+			{
+				_cell = &this->cells_[_pos & this->mask_];
+				const auto _seq = _cell->seq.load(std::memory_order_acquire);
+				const auto _diff = static_cast<std::intptr_t>(_seq) - static_cast<std::intptr_t>(_pos);
+				if (_diff == 0)
+				{
+					if (this->tail_.compare_exchange_weak(_pos, _pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					};
+				}
+				else if (_diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					_pos = this->tail_.load(std::memory_order_relaxed);
+				};
+			};
+
+			_cell->value = std::move(_value);
+			_cell->seq.store(_pos + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+		 * @brief Pops the oldest value, only call from the consumer thread
+		 * @return The value, nullopt if the queue is empty
+		*/
+		std::optional<value_type> try_pop() noexcept
+		{
+			const auto _pos = this->head_.load(std::memory_order_relaxed);
+			auto& _cell = this->cells_[_pos & this->mask_];
+			if (_cell.seq.load(std::memory_order_acquire) != _pos + 1)
+			{
+				return std::nullopt;
+			};
+
+			auto _out = std::move(_cell.value);
+			_cell.seq.store(_pos + this->capacity(), std::memory_order_release);
+			this->head_.store(_pos + 1, std::memory_order_release);
+			return _out;
+		};
+
+		/**
+		 * @brief Creates a queue, the capacity is rounded up to a power of two
+		*/
+		explicit MPSCQueue(size_type _capacity) :
+			mask_{ std::bit_ceil(std::max<size_type>(_capacity, 2)) - 1 },
+			cells_{ std::make_unique<cell[]>(this->mask_ + 1) }
+		{
+			for (size_type n = 0; n != this->capacity(); ++n)
+			{
+				this->cells_[n].seq.store(n, std::memory_order_relaxed);
+			};
+		};
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+	private:
+		struct cell
+		{
+			std::atomic<size_type> seq{};
+			value_type value{};
+		};
+
+		alignas(cache_line_size_v) std::atomic<size_type> head_{ 0 };
+		alignas(cache_line_size_v) std::atomic<size_type> tail_{ 0 };
+		alignas(cache_line_size_v) size_type mask_;
+		std::unique_ptr<cell[]> cells_;
+	};
+
+};
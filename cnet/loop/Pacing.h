@@ -0,0 +1,373 @@
+#pragma once
+
+/*
+	Send pacing and bandwidth shaping for stream sockets.
+
+	Each Pacer caps one connection's rate and may also draw from a TokenBucket shared by a group of
+	connections, capping their combined rate. Where SO_MAX_PACING_RATE is available the per-connection
+	cap is handed to the kernel, which spaces packets out itself with TCP's internal pacing or the fq
+	qdisc. Otherwise the cap is enforced here with a token bucket and the loop uses delay() as its timer
+	so the connection is flushed again once enough tokens have accumulated. Group caps always use the
+	user-space bucket as the kernel has no notion of them. Neither type is thread safe, keep a group to
+	connections served by one loop.
+
+		TokenBucket _group{ 100'000'000, 256 * 1024 };
+		Pacer _pacer{ 10'000'000, 64 * 1024, &_group };
+		_pacer.attach(_conn.socket());
+
+		const auto _now = Pacer::clock::now();
+		flush(_conn, _pacer, _now);
+		const auto _wait = _pacer.delay(_now, std::min(_conn.queued(), pacing_quantum_v));
+*/
+
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+#include <cnet/socket/SocketOption.h>
+#include <cnet/socket/BufferedConnection.h>
+
+#include <jclib/exception.h>
+
+#include <chrono>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Smallest number of bytes worth waking up to send, about two full sized segments
+	*/
+	constexpr inline size_t pacing_quantum_v = 2 * 1448;
+
+	/**
+	 * @brief Highest TokenBucket rate, larger rates are clamped so token arithmetic in nanoseconds cannot overflow.
+		About 18 GB/s, far above anything worth pacing.
+	*/
+	constexpr inline uint64_t max_token_rate_v = std::numeric_limits<uint64_t>::max() / 1'000'000'000ull;
+
+	namespace impl
+	{
+		constexpr inline uint64_t ns_per_second_v = 1'000'000'000ull;
+
+		/**
+		 * @brief Nanoseconds needed to earn the given number of tokens, saturates at the largest uint64_t
+		 * @param _rate Tokens per second, non-zero and at most max_token_rate_v
+		*/
+		constexpr inline uint64_t time_to_earn(uint64_t _tokens, uint64_t _rate, bool _roundUp) noexcept
+		{
+			const auto _whole = _tokens / _rate;
+			if (_whole >= std::numeric_limits<uint64_t>::max() / ns_per_second_v - 1)
+			{
+				return std::numeric_limits<uint64_t>::max();
+			};
+			// The remainder is below the rate so this multiply fits
+			const auto _rest = (_tokens % _rate) * ns_per_second_v;
+			const auto _partial = _rest / _rate + ((_roundUp && _rest % _rate != 0) ? 1 : 0);
+			return _whole * ns_per_second_v + _partial;
+		};
+
+		/**
+		 * @brief Tokens earned over the given nanoseconds, saturates at the largest uint64_t
+		 * @param _rate Tokens per second, at most max_token_rate_v
+		*/
+		constexpr inline uint64_t tokens_earned(uint64_t _ns, uint64_t _rate) noexcept
+		{
+			const auto _seconds = _ns / ns_per_second_v;
+			if (_rate != 0 && _seconds > (std::numeric_limits<uint64_t>::max() - _rate) / _rate)
+			{
+				return std::numeric_limits<uint64_t>::max();
+			};
+			// The remainder is below a second so this multiply fits
+			return _seconds * _rate + (_ns % ns_per_second_v) * _rate / ns_per_second_v;
+		};
+	};
+
+	/**
+	 * @brief Token bucket rate limiter measured in bytes
+	*/
+	struct TokenBucket
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+		using time_point = typename clock::time_point;
+		using duration = typename clock::duration;
+
+		/**
+		 * @brief Rate in bytes per second, 0 when unlimited
+		*/
+		uint64_t rate() const noexcept
+		{
+			return this->rate_;
+		};
+
+		/**
+		 * @brief Largest number of tokens the bucket holds, the most that can be sent in one burst
+		*/
+		uint64_t burst() const noexcept
+		{
+			return this->burst_;
+		};
+
+		bool unlimited() const noexcept
+		{
+			return this->rate_ == 0;
+		};
+
+		/**
+		 * @brief Changes the rate, tokens already held are kept up to the new burst size
+		*/
+		void set_rate(uint64_t _rate, uint64_t _burst, time_point _now = clock::now()) noexcept
+		{
+			this->refill(_now);
+			this->rate_ = std::min(_rate, max_token_rate_v);
+			this->burst_ = std::max<uint64_t>(_burst, 1);
+			this->tokens_ = std::min(this->tokens_, this->burst_);
+		};
+
+		/**
+		 * @brief Number of bytes which may be sent now
+		*/
+		uint64_t available(time_point _now) noexcept
+		{
+			if (this->unlimited())
+			{
+				return std::numeric_limits<uint64_t>::max();
+			};
+			this->refill(_now);
+			return this->tokens_;
+		};
+
+		/**
+		 * @brief Takes tokens for bytes that were sent
+		 * @param _bytes Bytes sent, at most the last value returned by available()
+		*/
+		void consume(uint64_t _bytes) noexcept
+		{
+			if (!this->unlimited())
+			{
+				JCLIB_ASSERT(_bytes <= this->tokens_);
+				this->tokens_ -= _bytes;
+			};
+		};
+
+		/**
+		 * @brief Time until the given number of bytes may be sent, zero if they can be sent now
+		*/
+		duration delay(time_point _now, uint64_t _bytes) noexcept
+		{
+			const auto _have = this->available(_now);
+			if (this->unlimited() || _have >= _bytes)
+			{
+				return duration::zero();
+			};
+			const auto _missing = std::min(_bytes, this->burst_) - std::min(_have, this->burst_);
+			const auto _ns = impl::time_to_earn(_missing, this->rate_, true);
+			if (_ns >= static_cast<uint64_t>(std::chrono::nanoseconds::max().count()))
+			{
+				return duration::max();
+			};
+			return std::chrono::duration_cast<duration>(std::chrono::nanoseconds{ static_cast<std::chrono::nanoseconds::rep>(_ns) });
+		};
+
+		TokenBucket() = default;
+
+		/**
+		 * @param _rate Bytes per second, 0 for unlimited, clamped to max_token_rate_v
+		 * @param _burst Bucket size in bytes, the bucket starts full
+		*/
+		TokenBucket(uint64_t _rate, uint64_t _burst, time_point _now = clock::now()) noexcept :
+			rate_{ std::min(_rate, max_token_rate_v) }, burst_{ std::max<uint64_t>(_burst, 1) }, tokens_{ this->burst_ }, last_{ _now }
+		{};
+
+	private:
+		void refill(time_point _now) noexcept
+		{
+			if (_now <= this->last_ || this->unlimited())
+			{
+				return;
+			};
+			const auto _elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(_now - this->last_).count());
+
+			// Anything idle long enough to fill an empty bucket is simply full
+			if (_elapsed >= impl::time_to_earn(this->burst_, this->rate_, true))
+			{
+				this->tokens_ = this->burst_;
+				this->last_ = _now;
+				return;
+			};
+
+			const auto _earned = impl::tokens_earned(_elapsed, this->rate_);
+			if (_earned == 0)
+			{
+				// Leave last_ alone so short intervals still accumulate
+				return;
+			};
+			if (_earned >= this->burst_ - this->tokens_)
+			{
+				this->tokens_ = this->burst_;
+				this->last_ = _now;
+			}
+			else
+			{
+				// Only advance by the time actually paid out so fractions of a byte are not lost
+				this->tokens_ += _earned;
+				const auto _paid = impl::time_to_earn(_earned, this->rate_, false);
+				this->last_ += std::chrono::duration_cast<duration>(std::chrono::nanoseconds{ static_cast<std::chrono::nanoseconds::rep>(_paid) });
+			};
+		};
+
+		uint64_t rate_ = 0;
+		uint64_t burst_ = 1;
+		uint64_t tokens_ = 0;
+		time_point last_{};
+	};
+
+	/**
+	 * @brief Paces one connection, optionally also drawing from a group bucket shared with other connections
+	*/
+	struct Pacer
+	{
+	public:
+		using clock = TokenBucket::clock;
+		using time_point = TokenBucket::time_point;
+		using duration = TokenBucket::duration;
+
+		/**
+		 * @brief Hands the per-connection rate to the kernel when it supports SO_MAX_PACING_RATE
+		 * @return True if the kernel is pacing, false if the user-space bucket is used, otherwise the socket error
+		*/
+		Result<bool> attach(socket_t _sock) noexcept
+		{
+			this->kernel_ = false;
+			if constexpr (max_pacing_rate::supported)
+			{
+				if (this->own_.unlimited() || this->own_.rate() > std::numeric_limits<uint32_t>::max())
+				{
+					return false;
+				};
+				const auto _result = set_option(_sock, max_pacing_rate{ static_cast<uint32_t>(this->own_.rate()) });
+				if (_result)
+				{
+					this->kernel_ = true;
+				}
+				else if (_result.error() != ERR_NOPROTOOPT && _result.error() != ERR_INVAL)
+				{
+					return _result.error();
+				};
+			};
+			return this->kernel_;
+		};
+
+		/**
+		 * @brief True if the per-connection rate is enforced by the kernel
+		*/
+		bool kernel_paced() const noexcept
+		{
+			return this->kernel_;
+		};
+
+		/**
+		 * @brief Number of bytes the connection may send now
+		*/
+		size_t allowance(time_point _now) noexcept
+		{
+			auto _out = std::numeric_limits<uint64_t>::max();
+			if (!this->kernel_)
+			{
+				_out = this->own_.available(_now);
+			};
+			if (this->group_)
+			{
+				_out = std::min(_out, this->group_->available(_now));
+			};
+			return static_cast<size_t>(std::min<uint64_t>(_out, std::numeric_limits<size_t>::max()));
+		};
+
+		/**
+		 * @brief Records bytes sent, at most the last allowance()
+		*/
+		void commit(size_t _bytes) noexcept
+		{
+			if (!this->kernel_)
+			{
+				this->own_.consume(_bytes);
+			};
+			if (this->group_)
+			{
+				this->group_->consume(_bytes);
+			};
+		};
+
+		/**
+		 * @brief Time until the given number of bytes may be sent, use it as the loop's timer for this connection
+		*/
+		duration delay(time_point _now, size_t _bytes) noexcept
+		{
+			auto _out = duration::zero();
+			if (!this->kernel_)
+			{
+				_out = this->own_.delay(_now, _bytes);
+			};
+			if (this->group_)
+			{
+				_out = std::max(_out, this->group_->delay(_now, _bytes));
+			};
+			return _out;
+		};
+
+		Pacer() = default;
+
+		/**
+		 * @param _rate Per-connection rate in bytes per second, 0 for unlimited
+		 * @param _burst Largest per-connection burst in bytes
+		 * @param _group Bucket shared with other connections for an aggregate limit, must outlive the pacer
+		*/
+		Pacer(uint64_t _rate, uint64_t _burst, TokenBucket* _group = nullptr) noexcept :
+			own_{ _rate, _burst }, group_{ _group }
+		{};
+
+	private:
+		TokenBucket own_{};
+		TokenBucket* group_ = nullptr;
+		bool kernel_ = false;
+	};
+
+	/**
+	 * @brief Sends as much of the given bytes as the pacer allows
+	 * @return Number of bytes sent, ERR_WOULDBLOCK if the pacer or the socket cannot take any yet
+	*/
+	inline Result<size_t> send(socket_t _sock, Pacer& _pacer, const void* _data, size_t _len, Pacer::time_point _now = Pacer::clock::now()) noexcept
+	{
+		const auto _allowed = std::min(_len, _pacer.allowance(_now));
+		if (_allowed == 0 && _len != 0)
+		{
+			return ERR_WOULDBLOCK;
+		};
+		const auto _result = send(_sock, _data, _allowed);
+		if (_result)
+		{
+			_pacer.commit(*_result);
+		};
+		return _result;
+	};
+
+	/**
+	 * @brief Flushes as much of a connection's queue as the pacer allows with one gathered write
+	 * @return Number of bytes sent, ERR_WOULDBLOCK if the pacer or the socket cannot take any yet
+	*/
+	inline Result<size_t> flush(BufferedConnection& _conn, Pacer& _pacer, Pacer::time_point _now = Pacer::clock::now())
+	{
+		const auto _allowed = std::min(_conn.queued(), _pacer.allowance(_now));
+		if (_allowed == 0 && _conn.queued() != 0)
+		{
+			return ERR_WOULDBLOCK;
+		};
+		const auto _result = _conn.flush(_allowed);
+		if (_result)
+		{
+			_pacer.commit(*_result);
+		};
+		return _result;
+	};
+
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+/*
+	Hands accepted sockets from acceptor threads to a worker loop.
+
+	Producers push into a lock-free MPSCQueue and only ring the worker's doorbell if the worker has
+	announced it is about to sleep with prepare_wait(), so a busy worker is never woken and a burst of
+	pushes costs at most one wakeup. Only available when CCAP_NET_UNIX is defined.
+*/
+
+#include <cnet/loop/Doorbell.h>
+#include <cnet/loop/MPSCQueue.h>
+
+#ifdef CCAP_NET_UNIX
+
+#include <span>
+#include <atomic>
+#include <optional>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Queue of sockets for a single worker loop paired with a doorbell to wake it
+	*/
+	struct SocketQueue
+	{
+	public:
+		using size_type = size_t;
+
+		/**
+		 * @brief Descriptor the worker adds to its poller, readable when sockets may be waiting
+		*/
+		socket_t fd() const noexcept
+		{
+			return this->doorbell_.fd();
+		};
+
+		size_type capacity() const noexcept
+		{
+			return this->queue_.capacity();
+		};
+		size_type size() const noexcept
+		{
+			return this->queue_.size();
+		};
+		bool empty() const noexcept
+		{
+			return this->queue_.empty();
+		};
+
+		/**
+		 * @brief Pushes a socket, safe to call from any thread
+		 * @return False if the queue is full, the caller still owns the socket
+		*/
+		bool push(socket_t _sock) noexcept
+		{
+			if (!this->queue_.try_push(_sock))
+			{
+				return false;
+			};
+			this->notify();
+			return true;
+		};
+
+		/**
+		 * @brief Pushes several sockets, ringing the doorbell at most once
+		 * @return Number of sockets pushed, the caller still owns any that did not fit
+		*/
+		size_type push(std::span<const socket_t> _socks) noexcept
+		{
+			size_type _count = 0;
+			for (auto& v : _socks)
+			{
+				if (!this->queue_.try_push(v))
+				{
+					break;
+				};
+				++_count;
+			};
+			if (_count != 0)
+			{
+				this->notify();
+			};
+			return _count;
+		};
+
+		/**
+		 * @brief Pops one socket, only call from the worker thread
+		*/
+		std::optional<socket_t> pop() noexcept
+		{
+			return this->queue_.try_pop();
+		};
+
+		/**
+		 * @brief Pops every queued socket passing each to the given function, only call from the worker thread
+		 * @return Number of sockets popped
+		*/
+		template <typename OpT>
+		size_type drain(OpT&& _op)
+		{
+			size_type _count = 0;
+			while (auto _sock = this->queue_.try_pop())
+			{
+				_op(*_sock);
+				++_count;
+			};
+			return _count;
+		};
+
+		/**
+		 * @brief Call from the worker before it blocks in its poller
+		 * @return False if sockets are already waiting and the worker should not block
+		*/
+		bool prepare_wait() noexcept
+		{
+			this->waiting_.store(true, std::memory_order_seq_cst);
+
+			// Pairs with the fence in notify(), either the producer sees waiting_ or this sees its push
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!this->queue_.empty())
+			{
+				this->waiting_.store(false, std::memory_order_relaxed);
+				return false;
+			};
+			return true;
+		};
+
+		/**
+		 * @brief Call from the worker once its poller reports fd() readable
+		*/
+		void acknowledge() noexcept
+		{
+			this->waiting_.store(false, std::memory_order_relaxed);
+			this->doorbell_.drain();
+		};
+
+		/**
+		 * @brief Creates a queue, the capacity is rounded up to a power of two
+		 * @param _doorbell Doorbell from Doorbell::open
+		*/
+		SocketQueue(size_type _capacity, Doorbell&& _doorbell) :
+			queue_{ _capacity },
+			doorbell_{ std::move(_doorbell) }
+		{
+			JCLIB_ASSERT(this->doorbell_.good());
+		};
+
+	private:
+		void notify() noexcept
+		{
+			// Orders the push before the load of waiting_, pairs with the fence in prepare_wait()
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (this->waiting_.load(std::memory_order_seq_cst) &&
+				this->waiting_.exchange(false, std::memory_order_acq_rel))
+			{
+				this->doorbell_.ring();
+			};
+		};
+
+		MPSCQueue<socket_t> queue_;
+		alignas(cache_line_size_v) std::atomic<bool> waiting_{ false };
+		Doorbell doorbell_;
+	};
+
+};
+
+#endif
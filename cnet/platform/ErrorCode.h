@@ -9,6 +9,17 @@
 
 #include <cnet/platform/Platform.h>
 
+#include <string>
+#include <system_error>
+
+#if defined(CCAP_NET_UNIX)
+// Selects the enumerator value for the target, errno values on Unix and adjusted Winsock values elsewhere
+#define CCAP_NET_ERRC(_unix, _other) _unix
+#else
+// Selects the enumerator value for the target, errno values on Unix and adjusted Winsock values elsewhere
+#define CCAP_NET_ERRC(_unix, _other) _other
+#endif
+
 namespace ccap::net
 {
 
@@ -24,142 +35,148 @@ namespace ccap::net
 		ERR_NONE = 0,
 
 		// Interrupted function call.
-		ERR_INTR = 4,
+		ERR_INTR = CCAP_NET_ERRC(EINTR, 4),
 
 		// File handle is not valid.
-		ERR_BADF = 9,
+		ERR_BADF = CCAP_NET_ERRC(EBADF, 9),
 
 		// Permission denied.
-		ERR_ACCES = 13,
+		ERR_ACCES = CCAP_NET_ERRC(EACCES, 13),
 
 		// Bad address.
-		ERR_FAULT = 14,
+		ERR_FAULT = CCAP_NET_ERRC(EFAULT, 14),
 
 		// Invalid argument.
-		ERR_INVAL = 22,
+		ERR_INVAL = CCAP_NET_ERRC(EINVAL, 22),
 
 		// Too many open files.
-		ERR_MFILE = 24,
+		ERR_MFILE = CCAP_NET_ERRC(EMFILE, 24),
 
 		// Resource temporarily unavailable.
-		ERR_WOULDBLOCK = 35,
+		ERR_WOULDBLOCK = CCAP_NET_ERRC(EWOULDBLOCK, 35),
 
 		// Operation now in progress.
-		ERR_INPROGRESS = 36,
+		ERR_INPROGRESS = CCAP_NET_ERRC(EINPROGRESS, 36),
 
 		// Operation already in progress.
-		ERR_ALREADY = 37,
+		ERR_ALREADY = CCAP_NET_ERRC(EALREADY, 37),
 
 		// Socket operation on nonsocket.
-		ERR_NOTSOCK = 38,
+		ERR_NOTSOCK = CCAP_NET_ERRC(ENOTSOCK, 38),
 
 		// Destination address required.
-		ERR_DESTADDRREQ = 39,
+		ERR_DESTADDRREQ = CCAP_NET_ERRC(EDESTADDRREQ, 39),
 
 		// Message too long.
-		ERR_MSGSIZE = 40,
+		ERR_MSGSIZE = CCAP_NET_ERRC(EMSGSIZE, 40),
 
 		// Protocol wrong type for socket.
-		ERR_PROTOTYPE = 41,
+		ERR_PROTOTYPE = CCAP_NET_ERRC(EPROTOTYPE, 41),
 
 		// Bad protocol option.
-		ERR_NOPROTOOPT = 42,
+		ERR_NOPROTOOPT = CCAP_NET_ERRC(ENOPROTOOPT, 42),
 
 		// Protocol not supported.
-		ERR_PROTONOSUPPORT = 43,
+		ERR_PROTONOSUPPORT = CCAP_NET_ERRC(EPROTONOSUPPORT, 43),
 
 		// Socket type not supported.
-		ERR_SOCKTNOSUPPORT = 44,
+		ERR_SOCKTNOSUPPORT = CCAP_NET_ERRC(ESOCKTNOSUPPORT, 44),
 
 		// Operation not supported.
-		ERR_OPNOTSUPP = 45,
+		ERR_OPNOTSUPP = CCAP_NET_ERRC(EOPNOTSUPP, 45),
 
 		// Protocol family not supported.
-		ERR_PFNOSUPPORT = 46,
+		ERR_PFNOSUPPORT = CCAP_NET_ERRC(EPFNOSUPPORT, 46),
 
 		// Address family not supported by protocol family.
-		ERR_AFNOSUPPORT = 47,
+		ERR_AFNOSUPPORT = CCAP_NET_ERRC(EAFNOSUPPORT, 47),
 
 		// Address already in use.
-		ERR_ADDRINUSE = 48,
+		ERR_ADDRINUSE = CCAP_NET_ERRC(EADDRINUSE, 48),
 
 		// Cannot assign requested address.
-		ERR_ADDRNOTAVAIL = 49,
+		ERR_ADDRNOTAVAIL = CCAP_NET_ERRC(EADDRNOTAVAIL, 49),
 
 		// Network is down.
-		ERR_NETDOWN = 50,
+		ERR_NETDOWN = CCAP_NET_ERRC(ENETDOWN, 50),
 
 		// Network is unreachable.
-		ERR_NETUNREACH = 51,
+		ERR_NETUNREACH = CCAP_NET_ERRC(ENETUNREACH, 51),
 
 		// Network dropped connection on reset.
-		ERR_NETRESET = 52,
+		ERR_NETRESET = CCAP_NET_ERRC(ENETRESET, 52),
 
 		// Software caused connection abort.
-		ERR_CONNABORTED = 53,
+		ERR_CONNABORTED = CCAP_NET_ERRC(ECONNABORTED, 53),
 
 		// Connection reset by peer.
-		ERR_CONNRESET = 54,
+		ERR_CONNRESET = CCAP_NET_ERRC(ECONNRESET, 54),
 
 		// No buffer space available.
-		ERR_NOBUFS = 55,
+		ERR_NOBUFS = CCAP_NET_ERRC(ENOBUFS, 55),
 
 		// Socket is already connected.
-		ERR_ISCONN = 56,
+		ERR_ISCONN = CCAP_NET_ERRC(EISCONN, 56),
 
 		// Socket is not connected.
-		ERR_NOTCONN = 57,
+		ERR_NOTCONN = CCAP_NET_ERRC(ENOTCONN, 57),
 
 		// Cannot send after socket shutdown.
-		ERR_SHUTDOWN = 58,
+		ERR_SHUTDOWN = CCAP_NET_ERRC(ESHUTDOWN, 58),
 
 		// Too many references.
-		ERR_TOOMANYREFS = 59,
+		ERR_TOOMANYREFS = CCAP_NET_ERRC(ETOOMANYREFS, 59),
 
 		// Connection timed out.
-		ERR_TIMEDOUT = 60,
+		ERR_TIMEDOUT = CCAP_NET_ERRC(ETIMEDOUT, 60),
 
 		// Connection refused.
-		ERR_CONNREFUSED = 61,
+		ERR_CONNREFUSED = CCAP_NET_ERRC(ECONNREFUSED, 61),
 
 		// Cannot translate name.
-		ERR_LOOP = 62,
+		ERR_LOOP = CCAP_NET_ERRC(ELOOP, 62),
 
 		// Name too long.
-		ERR_NAMETOOLONG = 63,
+		ERR_NAMETOOLONG = CCAP_NET_ERRC(ENAMETOOLONG, 63),
 
 		// Host is down.
-		ERR_HOSTDOWN = 64,
+		ERR_HOSTDOWN = CCAP_NET_ERRC(EHOSTDOWN, 64),
 
 		// No route to host.
-		ERR_HOSTUNREACH = 65,
+		ERR_HOSTUNREACH = CCAP_NET_ERRC(EHOSTUNREACH, 65),
 
 		// Directory not empty.
-		ERR_NOTEMPTY = 66,
+		ERR_NOTEMPTY = CCAP_NET_ERRC(ENOTEMPTY, 66),
 
 		// Too many processes.
-		ERR_PROCLIM = 67,
+		ERR_PROCLIM = CCAP_NET_ERRC(10067, 67),
 
 		// User quota exceeded.
-		ERR_USERS = 68,
+		ERR_USERS = CCAP_NET_ERRC(EUSERS, 68),
 
 		// Disk quota exceeded.
-		ERR_DQUOT = 69,
+		ERR_DQUOT = CCAP_NET_ERRC(EDQUOT, 69),
 
 		// Stale file handle reference.
-		ERR_STALE = 70,
+		ERR_STALE = CCAP_NET_ERRC(ESTALE, 70),
 
 		// Item is remote.
-		ERR_REMOTE = 71,
+		ERR_REMOTE = CCAP_NET_ERRC(EREMOTE, 71),
 
 		// Network subsystem is unavailable.
-		ERR_SYSNOTREADY = 91,
+		ERR_SYSNOTREADY = CCAP_NET_ERRC(10091, 91),
 
 		// Socketlib version out of range.
-		ERR_VERNOTSUPPORTED = 92,
+		ERR_VERNOTSUPPORTED = CCAP_NET_ERRC(10092, 92),
 
 		// Successful socketlib startup not yet performed.
-		ERR_NOTINITIALISED = 93
+		ERR_NOTINITIALISED = CCAP_NET_ERRC(10093, 93),
+
+		// Broken pipe, peer closed the connection before a send completed.
+		ERR_PIPE = CCAP_NET_ERRC(EPIPE, 32),
+
+		// Host name could not be resolved.
+		ERR_HOSTNOTFOUND = CCAP_NET_ERRC(11001, 1001)
 	};
 
 	// Expose socket error enumerations
@@ -174,7 +191,7 @@ namespace ccap::net
 #if defined(CCAP_NET_WINDOWS)
 		return WSAGetLastError();
 #elif defined(CCAP_NET_UNIX)
-		return errno();
+		return errno;
 #else
 		return (int)ERR_NONE;
 #endif
@@ -215,4 +232,76 @@ namespace ccap::net
 		return SocketError{ adjust_platform_error(get_platform_error()) };
 	};
 
+	namespace impl
+	{
+		/**
+		 * @brief Error category for SocketError values
+		*/
+		struct socket_error_category final : public std::error_category
+		{
+		public:
+			const char* name() const noexcept override
+			{
+				return "ccap::net::socket";
+			};
+
+			std::string message(int _code) const override
+			{
+				switch (SocketError{ _code })
+				{
+				case ERR_NONE:
+					return "no error";
+				case ERR_ERROR:
+					return "unknown socket error";
+				case ERR_HOSTNOTFOUND:
+					return "host not found";
+				default:
+					break;
+				};
+#if defined(CCAP_NET_WINDOWS)
+				return std::system_category().message(_code + impl::platform_error_offset_v);
+#else
+				return std::generic_category().message(_code);
+#endif
+			};
+
+			std::error_condition default_error_condition(int _code) const noexcept override
+			{
+				switch (SocketError{ _code })
+				{
+				case ERR_ERROR: [[fallthrough]];
+				case ERR_HOSTNOTFOUND:
+					return std::error_condition{ _code, *this };
+				default:
+					break;
+				};
+#if defined(CCAP_NET_WINDOWS)
+				return std::system_category().default_error_condition(_code + impl::platform_error_offset_v);
+#else
+				return std::error_condition{ _code, std::generic_category() };
+#endif
+			};
+		};
+	};
+
+	/**
+	 * @brief Returns the error category for SocketError values
+	*/
+	inline const std::error_category& socket_category() noexcept
+	{
+		static const impl::socket_error_category _category{};
+		return _category;
+	};
+
+	/**
+	 * @brief Converts a SocketError into a std::error_code, comparable against std::errc
+	*/
+	inline std::error_code make_error_code(SocketError _err) noexcept
+	{
+		return std::error_code{ static_cast<int>(_err), socket_category() };
+	};
+
 };
+
+template <>
+struct std::is_error_code_enum<ccap::net::SocketError> : std::true_type {};
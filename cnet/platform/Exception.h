@@ -20,8 +20,13 @@ namespace ccap::net
 			return this->code_;
 		};
 
+		const char* what() const noexcept override
+		{
+			return (this->what_)? this->what_ : "socket_exception";
+		};
+
 		socket_exception(SocketError _code, const char* _what) :
-			std::exception{ _what }, code_{ _code }
+			code_{ _code }, what_{ _what }
 		{};
 		socket_exception(SocketError _code) :
 			socket_exception{ _code, nullptr }
@@ -29,5 +34,6 @@ namespace ccap::net
 
 	private:
 		SocketError code_ = SocketError::ERR_ERROR;
+		const char* what_ = nullptr;
 	};
 };
@@ -67,7 +67,7 @@ namespace ccap::net
 #if CCAP_NET_TARGET == CCAP_NET_TARGET_PLATFORM_WINDOWS
 // Defined if Windows is the determined target platform
 #define CCAP_NET_WINDOWS
-#elif CCAP_NET_TARGET == CACP_NET_TARGET_PLATORM_UNIX
+#elif CCAP_NET_TARGET == CCAP_NET_TARGET_PLATFORM_UNIX
 // Defined if Unix or similar is the determined target platform
 #define CCAP_NET_UNIX
 #endif
@@ -85,6 +85,19 @@ namespace ccap::net
 #elif defined(CCAP_NET_UNIX)
 
 #include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #endif
 
@@ -0,0 +1,294 @@
+#pragma once
+
+/*
+	Result type returned by the socket functions.
+
+	Holds either a value or the SocketError captured at the point of failure, it never allocates
+	and only throws if value() is called on an error. Checking for ERR_WOULDBLOCK is a single
+	integer compare so non-blocking fast paths can test for it without unwinding.
+*/
+
+#include <cnet/platform/ErrorCode.h>
+#include <cnet/platform/Exception.h>
+
+#include <jclib/exception.h>
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <system_error>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Holds either a value or the socket error explaining why there is none
+	 * @tparam T Value type, may be void
+	*/
+	template <typename T>
+	struct Result
+	{
+	public:
+		using value_type = T;
+		using error_type = SocketError;
+
+		constexpr bool has_value() const noexcept
+		{
+			return this->error_ == ERR_NONE;
+		};
+		constexpr explicit operator bool() const noexcept
+		{
+			return this->has_value();
+		};
+
+		/**
+		 * @brief Returns the error, ERR_NONE if a value is held
+		*/
+		constexpr error_type error() const noexcept
+		{
+			return this->error_;
+		};
+		std::error_code error_code() const noexcept
+		{
+			return make_error_code(this->error_);
+		};
+
+		/**
+		 * @brief True if the call failed only because it would have blocked
+		*/
+		constexpr bool would_block() const noexcept
+		{
+			return this->error_ == ERR_WOULDBLOCK;
+		};
+
+		value_type& operator*() & noexcept
+		{
+			JCLIB_ASSERT(this->has_value());
+			return this->value_;
+		};
+		const value_type& operator*() const& noexcept
+		{
+			JCLIB_ASSERT(this->has_value());
+			return this->value_;
+		};
+		value_type&& operator*() && noexcept
+		{
+			JCLIB_ASSERT(this->has_value());
+			return std::move(this->value_);
+		};
+
+		value_type* operator->() noexcept
+		{
+			return &**this;
+		};
+		const value_type* operator->() const noexcept
+		{
+			return &**this;
+		};
+
+		/**
+		 * @brief Returns the value, throws socket_exception if an error is held
+		*/
+		value_type& value() &
+		{
+			this->check();
+			return this->value_;
+		};
+		const value_type& value() const&
+		{
+			this->check();
+			return this->value_;
+		};
+		value_type&& value() &&
+		{
+			this->check();
+			return std::move(this->value_);
+		};
+
+		template <typename U>
+		value_type value_or(U&& _default) const&
+		{
+			return (this->has_value()) ? this->value_ : static_cast<value_type>(std::forward<U>(_default));
+		};
+		template <typename U>
+		value_type value_or(U&& _default) &&
+		{
+			return (this->has_value()) ? std::move(this->value_) : static_cast<value_type>(std::forward<U>(_default));
+		};
+
+		Result(const value_type& _value) noexcept(std::is_nothrow_copy_constructible_v<value_type>) :
+			value_{ _value }, error_{ ERR_NONE }
+		{};
+		Result(value_type&& _value) noexcept(std::is_nothrow_move_constructible_v<value_type>) :
+			value_{ std::move(_value) }, error_{ ERR_NONE }
+		{};
+		/**
+		 * @brief Constructs an error result, ERR_NONE is stored as ERR_ERROR so an error result never reports success
+		*/
+		Result(error_type _err) noexcept :
+			error_{ (_err == ERR_NONE) ? ERR_ERROR : _err }
+		{
+			if constexpr (std::is_trivially_default_constructible_v<value_type>)
+			{
+				// Keeps trivial copies of an error result fully initialized
+				std::construct_at(&this->value_);
+			};
+		};
+
+		Result(const Result&) requires std::is_trivially_copy_constructible_v<value_type> = default;
+		Result(const Result& other) noexcept(std::is_nothrow_copy_constructible_v<value_type>)
+			requires (std::is_copy_constructible_v<value_type> && !std::is_trivially_copy_constructible_v<value_type>) :
+			error_{ other.error_ }
+		{
+			if (other.has_value())
+			{
+				std::construct_at(&this->value_, other.value_);
+			};
+		};
+
+		Result(Result&&) requires std::is_trivially_move_constructible_v<value_type> = default;
+		Result(Result&& other) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+			requires (!std::is_trivially_move_constructible_v<value_type>) :
+			error_{ other.error_ }
+		{
+			if (other.has_value())
+			{
+				std::construct_at(&this->value_, std::move(other.value_));
+			};
+		};
+
+		Result& operator=(const Result&) requires std::is_trivially_copyable_v<value_type> = default;
+		Result& operator=(const Result& other)
+			requires (std::is_copy_constructible_v<value_type> && !std::is_trivially_copyable_v<value_type>)
+		{
+			if (this != &other)
+			{
+				// Hold an error while the slot is empty so a throwing constructor leaves nothing to destroy twice
+				this->destroy();
+				this->error_ = ERR_ERROR;
+				if (other.has_value())
+				{
+					std::construct_at(&this->value_, other.value_);
+				};
+				this->error_ = other.error_;
+			};
+			return *this;
+		};
+		Result& operator=(Result&&) requires std::is_trivially_copyable_v<value_type> = default;
+		Result& operator=(Result&& other) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+			requires (!std::is_trivially_copyable_v<value_type>)
+		{
+			if (this != &other)
+			{
+				// Hold an error while the slot is empty so a throwing constructor leaves nothing to destroy twice
+				this->destroy();
+				this->error_ = ERR_ERROR;
+				if (other.has_value())
+				{
+					std::construct_at(&this->value_, std::move(other.value_));
+				};
+				this->error_ = other.error_;
+			};
+			return *this;
+		};
+
+		~Result() requires std::is_trivially_destructible_v<value_type> = default;
+		~Result()
+		{
+			this->destroy();
+		};
+
+	private:
+		void check() const
+		{
+			if (!this->has_value()) [[unlikely]]
+			{
+				if constexpr (JCLIB_EXCEPTIONS)
+				{
+					throw socket_exception{ this->error_, "on Result::value" };
+				}
+				else
+				{
+					JCLIB_ABORT();
+				};
+			};
+		};
+		void destroy() noexcept
+		{
+			if constexpr (!std::is_trivially_destructible_v<value_type>)
+			{
+				if (this->has_value())
+				{
+					std::destroy_at(&this->value_);
+				};
+			};
+		};
+
+		union
+		{
+			value_type value_;
+		};
+		error_type error_;
+	};
+
+	/**
+	 * @brief Result of an operation with no value, holds only the socket error
+	*/
+	template <>
+	struct Result<void>
+	{
+	public:
+		using value_type = void;
+		using error_type = SocketError;
+
+		constexpr bool has_value() const noexcept
+		{
+			return this->error_ == ERR_NONE;
+		};
+		constexpr explicit operator bool() const noexcept
+		{
+			return this->has_value();
+		};
+
+		constexpr error_type error() const noexcept
+		{
+			return this->error_;
+		};
+		std::error_code error_code() const noexcept
+		{
+			return make_error_code(this->error_);
+		};
+
+		constexpr bool would_block() const noexcept
+		{
+			return this->error_ == ERR_WOULDBLOCK;
+		};
+
+		/**
+		 * @brief Throws socket_exception if an error is held
+		*/
+		void value() const
+		{
+			if (!this->has_value()) [[unlikely]]
+			{
+				if constexpr (JCLIB_EXCEPTIONS)
+				{
+					throw socket_exception{ this->error_, "on Result::value" };
+				}
+				else
+				{
+					JCLIB_ABORT();
+				};
+			};
+		};
+
+		constexpr Result() noexcept = default;
+		constexpr Result(error_type _err) noexcept :
+			error_{ _err }
+		{};
+
+	private:
+		error_type error_ = ERR_NONE;
+	};
+
+};
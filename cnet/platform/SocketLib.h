@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cnet/platform/Exception.h>
+#include <cnet/platform/Result.h>
 #include <jclib/exception.h>
 
 #include <optional>
@@ -8,6 +9,7 @@
 #include <bit>
 #include <concepts>
 #include <cerrno>
+#include <utility>
 
 namespace ccap::net
 {
@@ -85,6 +87,25 @@ namespace ccap::net
 		SocketLibrary() = default;
 #endif
 
+		/**
+		 * @brief Starts the socket library without throwing
+		 * @param _version Requested socket library version
+		 * @return The started library, otherwise the startup error
+		*/
+		static Result<SocketLibrary> start(SocketLibraryVersion _version) noexcept
+		{
+			SocketLibrary _lib{ unstarted_t{} };
+#ifdef CCAP_NET_WINDOWS
+			const auto _result = WSAStartup(_version, &_lib.data_);
+			if (_result != 0)
+			{
+				return (SocketError)adjust_platform_error(_result);
+			};
+#endif
+			_lib.alive_ = true;
+			return _lib;
+		};
+
 		SocketLibrary(const SocketLibrary&) = delete;
 		SocketLibrary& operator=(const SocketLibrary&) = delete;
 
@@ -113,6 +134,11 @@ namespace ccap::net
 			this->reset();
 		};
 	private:
+		struct unstarted_t {};
+		explicit SocketLibrary(unstarted_t) noexcept :
+			alive_{ false }
+		{};
+
 		bool alive_ = true;
 #ifdef CCAP_NET_WINDOWS
 		WSAData data_;
@@ -0,0 +1,668 @@
+#pragma once
+
+/*
+	In-process simulated network implementing cx_transport, for benchmarking and testing protocol code
+	without the kernel.
+
+	Connections are pairs of in-memory ring buffers driven by a virtual clock. Bytes written with send()
+	are split into segments which arrive at the peer after the configured transmit time and latency, a
+	lost segment is delivered late by the retransmit delay and holds back everything behind it just as
+	TCP would. Nothing happens between calls: time only moves inside poll(), advance() and run(), and
+	events due at the same instant fire in the order they were scheduled. A given seed and sequence of
+	calls therefore always produces the same interleaving.
+
+		SimNetwork _net{ SimConfig{ .latency = 1ms, .loss = 0.01 } };
+		auto _listener = *_net.new_listener("server", "80", 16);
+		auto _client = *_net.connect("server", "80");
+*/
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
+#include <cnet/socket/Transport.h>
+
+#include <jclib/exception.h>
+
+#include <map>
+#include <span>
+#include <deque>
+#include <queue>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Link behaviour of a SimNetwork, applied to each direction of every connection
+	*/
+	struct SimConfig
+	{
+		// One way propagation delay.
+		std::chrono::nanoseconds latency{ std::chrono::microseconds{ 50 } };
+
+		// Bytes per second in each direction, 0 for unlimited.
+		uint64_t bandwidth = 0;
+
+		// Probability each segment is lost and has to be retransmitted, 0 to 1.
+		double loss = 0.0;
+
+		// Extra delay a lost segment sees before it arrives.
+		std::chrono::nanoseconds retransmit_delay{ std::chrono::milliseconds{ 200 } };
+
+		// Receive window of each socket, bounds the bytes in flight plus unread.
+		size_t buffer_size = 256 * 1024;
+
+		// Largest number of bytes carried by one segment.
+		size_t segment_size = 16 * 1024;
+
+		// Seed for the loss generator.
+		uint64_t seed = 1;
+	};
+
+	/**
+	 * @brief Counters kept by a SimNetwork
+	*/
+	struct SimStats
+	{
+		uint64_t segments = 0;
+		uint64_t lost = 0;
+		uint64_t bytes = 0;
+		uint64_t connections = 0;
+	};
+
+	namespace impl
+	{
+		/**
+		 * @brief Fixed capacity byte ring buffer
+		*/
+		struct ByteRing
+		{
+		public:
+			size_t size() const noexcept
+			{
+				return this->size_;
+			};
+			size_t capacity() const noexcept
+			{
+				return this->data_.size();
+			};
+			size_t space() const noexcept
+			{
+				return this->capacity() - this->size();
+			};
+			bool empty() const noexcept
+			{
+				return this->size_ == 0;
+			};
+
+			void push(const std::byte* _data, size_t _len) noexcept
+			{
+				JCLIB_ASSERT(_len <= this->space());
+				auto _tail = (this->head_ + this->size_) % this->capacity();
+				while (_len != 0)
+				{
+					const auto _count = std::min(_len, this->capacity() - _tail);
+					std::copy_n(_data, _count, this->data_.data() + _tail);
+					_data += _count;
+					_len -= _count;
+					this->size_ += _count;
+					_tail = 0;
+				};
+			};
+
+			size_t pop(std::byte* _dest, size_t _len) noexcept
+			{
+				_len = std::min(_len, this->size_);
+				const auto _out = _len;
+				while (_len != 0)
+				{
+					const auto _count = std::min(_len, this->capacity() - this->head_);
+					if (_dest)
+					{
+						std::copy_n(this->data_.data() + this->head_, _count, _dest);
+						_dest += _count;
+					};
+					_len -= _count;
+					this->size_ -= _count;
+					this->head_ = (this->head_ + _count) % this->capacity();
+				};
+				return _out;
+			};
+
+			/**
+			 * @brief Moves bytes from the front of this ring onto the back of another
+			*/
+			void transfer(ByteRing& _to, size_t _len) noexcept
+			{
+				JCLIB_ASSERT(_len <= this->size_ && _len <= _to.space());
+				while (_len != 0)
+				{
+					const auto _count = std::min(_len, this->capacity() - this->head_);
+					_to.push(this->data_.data() + this->head_, _count);
+					_len -= _count;
+					this->size_ -= _count;
+					this->head_ = (this->head_ + _count) % this->capacity();
+				};
+			};
+
+			ByteRing() = default;
+			explicit ByteRing(size_t _capacity) :
+				data_(_capacity)
+			{};
+
+		private:
+			std::vector<std::byte> data_{};
+			size_t head_ = 0;
+			size_t size_ = 0;
+		};
+	};
+
+	/**
+	 * @brief Deterministic in-memory network, not thread safe
+	*/
+	struct SimNetwork
+	{
+	public:
+		using clock_duration = std::chrono::nanoseconds;
+
+		/**
+		 * @brief Current virtual time since the network was created
+		*/
+		clock_duration now() const noexcept
+		{
+			return this->now_;
+		};
+
+		const SimConfig& config() const noexcept
+		{
+			return this->config_;
+		};
+		const SimStats& stats() const noexcept
+		{
+			return this->stats_;
+		};
+
+		/**
+		 * @brief Creates a listener, the address and service are just a name other sockets connect to
+		 * @return The listening socket, ERR_ADDRINUSE if the name is taken
+		*/
+		Result<socket_t> new_listener(const char* _address, const char* _service, int _backlog)
+		{
+			auto _name = make_name(_address, _service);
+			if (this->listeners_.contains(_name))
+			{
+				return ERR_ADDRINUSE;
+			};
+
+			const auto _sock = this->next_socket_++;
+			auto& _listener = this->sockets_[_sock];
+			_listener.is_listener = true;
+			_listener.backlog = static_cast<size_t>(std::max(_backlog, 1));
+			_listener.name = _name;
+			this->listeners_.emplace(std::move(_name), _sock);
+			return _sock;
+		};
+
+		/**
+		 * @brief Connects to a listener. The socket is usable at once, the listener sees the connection
+			after one latency and bytes sent before then are delivered behind it.
+		 * @return The connected socket, ERR_CONNREFUSED if nothing listens on the name
+		*/
+		Result<socket_t> connect(const char* _address, const char* _service)
+		{
+			const auto _it = this->listeners_.find(make_name(_address, _service));
+			if (_it == this->listeners_.end())
+			{
+				return ERR_CONNREFUSED;
+			};
+
+			const auto _client = this->next_socket_++;
+			const auto _server = this->next_socket_++;
+			this->open_stream(_client, _server);
+			this->open_stream(_server, _client);
+
+			this->schedule(this->now_ + this->config_.latency, event_kind::syn, _it->second, _server, 0);
+			++this->stats_.connections;
+			return _client;
+		};
+
+		/**
+		 * @brief Accepts a connection which has reached the listener
+		 * @return The accepted socket, ERR_WOULDBLOCK if none are pending
+		*/
+		Result<socket_t> accept(socket_t _listener)
+		{
+			auto _it = this->sockets_.find(_listener);
+			if (_it == this->sockets_.end() || !_it->second.is_listener)
+			{
+				return (_it == this->sockets_.end()) ? ERR_BADF : ERR_INVAL;
+			};
+
+			auto& _pending = _it->second.pending;
+			if (_pending.empty())
+			{
+				return ERR_WOULDBLOCK;
+			};
+			const auto _out = _pending.front();
+			_pending.pop_front();
+			return _out;
+		};
+
+		/**
+		 * @brief Queues bytes for delivery, accepts no more than the peer's receive window allows
+		 * @return Number of bytes accepted, ERR_WOULDBLOCK if the window is full, ERR_PIPE once the peer has closed
+		*/
+		Result<size_t> send(socket_t _sock, const void* _data, size_t _len)
+		{
+			auto _self = this->find_stream(_sock);
+			if (!_self)
+			{
+				return ERR_BADF;
+			};
+			if (_self->error != ERR_NONE)
+			{
+				return _self->error;
+			};
+			if (_self->peer_closed)
+			{
+				return ERR_PIPE;
+			};
+
+			const auto _peer = this->find_stream(_self->peer);
+			const auto _unread = (_peer) ? _peer->rx.size() : 0;
+			const auto _window = this->config_.buffer_size - std::min(this->config_.buffer_size, _self->tx.size() + _unread);
+			_len = std::min(_len, _window);
+			if (_len == 0)
+			{
+				return ERR_WOULDBLOCK;
+			};
+
+			_self->tx.push(static_cast<const std::byte*>(_data), _len);
+			for (size_t _at = 0; _at != _len;)
+			{
+				const auto _count = std::min(_len - _at, this->config_.segment_size);
+				this->send_segment(_sock, *_self, _count);
+				_at += _count;
+			};
+			return _len;
+		};
+
+		/**
+		 * @brief Receives delivered bytes
+		 * @return Number of bytes received, 0 once the peer has closed and everything was read,
+			ERR_WOULDBLOCK if nothing has arrived yet
+		*/
+		Result<size_t> recv(socket_t _sock, void* _data, size_t _len)
+		{
+			auto _self = this->find_stream(_sock);
+			if (!_self)
+			{
+				return ERR_BADF;
+			};
+			if (!_self->rx.empty())
+			{
+				return _self->rx.pop(static_cast<std::byte*>(_data), _len);
+			};
+			if (_self->error != ERR_NONE)
+			{
+				return _self->error;
+			};
+			if (_self->peer_closed)
+			{
+				return size_t{ 0 };
+			};
+			return ERR_WOULDBLOCK;
+		};
+
+		/**
+		 * @brief Closes a socket, bytes already sent are still delivered before the peer sees the close
+		*/
+		Result<void> close(socket_t _sock)
+		{
+			auto _it = this->sockets_.find(_sock);
+			if (_it == this->sockets_.end() || _it->second.closed)
+			{
+				return ERR_BADF;
+			};
+
+			auto& _self = _it->second;
+			if (_self.is_listener)
+			{
+				// Connections nobody accepted are reset
+				for (auto& v : _self.pending)
+				{
+					if (auto _stream = this->find_stream(v))
+					{
+						this->reset_peer(*_stream);
+					};
+					this->sockets_.erase(v);
+				};
+				this->listeners_.erase(_self.name);
+				this->sockets_.erase(_it);
+				return {};
+			};
+
+			_self.closed = true;
+			const auto _at = std::max(this->now_ + this->config_.latency, _self.last_delivery);
+			this->schedule(_at, event_kind::fin, _self.peer, _sock, 0);
+			if (_self.tx.empty())
+			{
+				this->sockets_.erase(_it);
+			};
+			return {};
+		};
+
+		/**
+		 * @brief Fills in revents for each entry, advancing virtual time until one is ready or the timeout passes.
+			A negative timeout waits until something is ready, or returns 0 if no event could ever make it so.
+		 * @return Number of ready entries
+		*/
+		Result<int> poll(std::span<::pollfd> _fds, std::chrono::milliseconds _timeout)
+		{
+			const auto _deadline = (_timeout.count() < 0) ? clock_duration::max() : this->now_ + _timeout;
+			while (true)
+			{
+				int _ready = 0;
+				for (auto& v : _fds)
+				{
+					v.revents = this->readiness(v.fd, v.events);
+					_ready += (v.revents != 0) ? 1 : 0;
+				};
+				if (_ready != 0 || this->events_.empty() || this->events_.top().at > _deadline)
+				{
+					if (_ready == 0 && _deadline != clock_duration::max())
+					{
+						this->now_ = std::max(this->now_, _deadline);
+					};
+					return _ready;
+				};
+				this->step();
+			};
+		};
+
+		/**
+		 * @brief Readiness of a single socket
+		 * @param _events Combination of POLLIN and POLLOUT to test for
+		*/
+		short readiness(socket_t _sock, short _events) const noexcept
+		{
+			if (_sock == nullsock)
+			{
+				// Ignored like a negative descriptor in a real poll
+				return 0;
+			};
+
+			const auto _it = this->sockets_.find(_sock);
+			if (_it == this->sockets_.end() || _it->second.closed)
+			{
+				return POLLNVAL;
+			};
+
+			const auto& _self = _it->second;
+			short _out = 0;
+			if (_self.is_listener)
+			{
+				_out |= static_cast<short>((_self.pending.empty()) ? 0 : POLLIN);
+				return _out & _events;
+			};
+
+			if (!_self.rx.empty() || _self.peer_closed || _self.error != ERR_NONE)
+			{
+				_out |= POLLIN;
+			};
+
+			const auto _peer = this->sockets_.find(_self.peer);
+			const auto _unread = (_peer != this->sockets_.end()) ? _peer->second.rx.size() : 0;
+			if (_self.tx.size() + _unread < this->config_.buffer_size)
+			{
+				_out |= POLLOUT;
+			};
+
+			_out &= _events;
+			if (_self.error != ERR_NONE)
+			{
+				_out |= POLLERR;
+			};
+			if (_self.peer_closed)
+			{
+				_out |= POLLHUP;
+			};
+			return _out;
+		};
+
+		/**
+		 * @brief Runs every event due within the given time and moves the clock forward by it
+		*/
+		void advance(clock_duration _duration)
+		{
+			const auto _until = this->now_ + _duration;
+			while (!this->events_.empty() && this->events_.top().at <= _until)
+			{
+				this->step();
+			};
+			this->now_ = _until;
+		};
+
+		/**
+		 * @brief Runs events until none are left
+		*/
+		void run()
+		{
+			while (!this->events_.empty())
+			{
+				this->step();
+			};
+		};
+
+		explicit SimNetwork(SimConfig _config = {}) :
+			config_{ _config }, rng_{ _config.seed }
+		{
+			JCLIB_ASSERT(this->config_.buffer_size != 0 && this->config_.segment_size != 0);
+		};
+
+	private:
+		enum class event_kind : uint8_t
+		{
+			syn,
+			data,
+			fin
+		};
+
+		struct event
+		{
+			clock_duration at;
+			uint64_t seq;
+			event_kind kind;
+			socket_t to;
+			socket_t from;
+			size_t bytes;
+
+			bool operator>(const event& other) const noexcept
+			{
+				return (this->at != other.at) ? (this->at > other.at) : (this->seq > other.seq);
+			};
+		};
+
+		struct endpoint
+		{
+			// Listener state
+			bool is_listener = false;
+			size_t backlog = 0;
+			std::deque<socket_t> pending{};
+			std::string name{};
+
+			// Stream state
+			socket_t peer = nullsock;
+			impl::ByteRing rx{};
+			impl::ByteRing tx{};
+			clock_duration link_free{};
+			clock_duration last_delivery{};
+			SocketError error = ERR_NONE;
+			bool peer_closed = false;
+			bool closed = false;
+		};
+
+		static std::string make_name(const char* _address, const char* _service)
+		{
+			auto _out = std::string{ _address };
+			_out.push_back(':');
+			_out.append(_service);
+			return _out;
+		};
+
+		endpoint* find_stream(socket_t _sock) noexcept
+		{
+			const auto _it = this->sockets_.find(_sock);
+			if (_it == this->sockets_.end() || _it->second.is_listener || _it->second.closed)
+			{
+				return nullptr;
+			};
+			return &_it->second;
+		};
+
+		void open_stream(socket_t _sock, socket_t _peer)
+		{
+			auto& _self = this->sockets_[_sock];
+			_self.peer = _peer;
+			_self.rx = impl::ByteRing{ this->config_.buffer_size };
+			_self.tx = impl::ByteRing{ this->config_.buffer_size };
+			_self.link_free = this->now_;
+			_self.last_delivery = this->now_;
+		};
+
+		/**
+		 * @brief Resets the other end of a stream which is about to be erased, it stops sending to the missing socket
+		*/
+		void reset_peer(endpoint& _self) noexcept
+		{
+			if (auto _peer = this->find_stream(_self.peer))
+			{
+				_peer->error = ERR_CONNRESET;
+				_peer->peer = nullsock;
+			};
+		};
+
+		/**
+		 * @brief Uniform random value in [0, 1) from a splitmix64 generator, identical on every platform
+		*/
+		double random() noexcept
+		{
+			auto _z = (this->rng_ += 0x9E3779B97F4A7C15ull);
+			_z = (_z ^ (_z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			_z = (_z ^ (_z >> 27)) * 0x94D049BB133111EBull;
+			_z ^= (_z >> 31);
+			return static_cast<double>(_z >> 11) * 0x1.0p-53;
+		};
+
+		void send_segment(socket_t _sock, endpoint& _self, size_t _bytes)
+		{
+			auto _transmit = clock_duration{};
+			if (this->config_.bandwidth != 0)
+			{
+				_transmit = clock_duration{ static_cast<clock_duration::rep>(_bytes * 1'000'000'000ull / this->config_.bandwidth) };
+			};
+			_self.link_free = std::max(_self.link_free, this->now_) + _transmit;
+
+			auto _at = _self.link_free + this->config_.latency;
+			if (this->config_.loss > 0.0 && this->random() < this->config_.loss)
+			{
+				_at += this->config_.retransmit_delay;
+				++this->stats_.lost;
+			};
+
+			// Delivery is in order, a late segment holds back the ones behind it
+			_at = std::max(_at, _self.last_delivery);
+			_self.last_delivery = _at;
+			++this->stats_.segments;
+			this->schedule(_at, event_kind::data, _self.peer, _sock, _bytes);
+		};
+
+		void schedule(clock_duration _at, event_kind _kind, socket_t _to, socket_t _from, size_t _bytes)
+		{
+			this->events_.push(event{ _at, this->next_seq_++, _kind, _to, _from, _bytes });
+		};
+
+		/**
+		 * @brief Runs the earliest event and moves the clock to it
+		*/
+		void step()
+		{
+			const auto _event = this->events_.top();
+			this->events_.pop();
+			this->now_ = std::max(this->now_, _event.at);
+
+			switch (_event.kind)
+			{
+			case event_kind::syn:
+			{
+				auto _listener = this->sockets_.find(_event.to);
+				auto _server = this->find_stream(_event.from);
+				if (!_server)
+				{
+					break;
+				};
+				if (_listener == this->sockets_.end() || _listener->second.pending.size() >= _listener->second.backlog)
+				{
+					// Nobody to accept it, the client sees a reset
+					this->reset_peer(*_server);
+					this->sockets_.erase(_event.from);
+					break;
+				};
+				_listener->second.pending.push_back(_event.from);
+				break;
+			}
+			case event_kind::data:
+			{
+				auto _from = this->sockets_.find(_event.from);
+				JCLIB_ASSERT(_from != this->sockets_.end());
+				auto& _sender = _from->second;
+
+				if (auto _to = this->find_stream(_event.to))
+				{
+					_sender.tx.transfer(_to->rx, _event.bytes);
+					this->stats_.bytes += _event.bytes;
+				}
+				else
+				{
+					_sender.tx.pop(nullptr, _event.bytes);
+				};
+
+				if (_sender.closed && _sender.tx.empty())
+				{
+					this->sockets_.erase(_from);
+				};
+				break;
+			}
+			case event_kind::fin:
+			{
+				if (auto _to = this->find_stream(_event.to))
+				{
+					_to->peer_closed = true;
+				};
+				break;
+			}
+			};
+		};
+
+		SimConfig config_;
+		SimStats stats_{};
+		uint64_t rng_;
+		clock_duration now_{};
+
+		std::unordered_map<socket_t, endpoint> sockets_{};
+		std::map<std::string, socket_t, std::less<>> listeners_{};
+		std::priority_queue<event, std::vector<event>, std::greater<event>> events_{};
+		uint64_t next_seq_ = 0;
+		socket_t next_socket_ = 1000;
+	};
+
+	static_assert(cx_transport<SimNetwork>, "SimNetwork must satisfy cx_transport");
+
+};
@@ -1,11 +1,23 @@
 #pragma once
 
 #include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
 
 #include <jclib/ranges.h>
 #include <jclib/iterator.h>
 
+#include <bit>
+#include <span>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <compare>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <algorithm>
 
 namespace ccap::net
 {
@@ -249,27 +261,475 @@ namespace ccap::net
 	};
 
 
-	inline AddrList getaddrinfo(const char* _name, const char* _service, ::addrinfo& _hints)
+
+	/**
+	 * @brief A single resolved address stored by value, trivially copyable
+	*/
+	struct Endpoint
 	{
-		addrinfo* _out{};
-		const auto _result = ::getaddrinfo(_name, _service, &_hints, &_out);
-		if (_result != 0)
+	public:
+		const ::sockaddr* get() const noexcept
+		{
+			return reinterpret_cast<const ::sockaddr*>(&this->addr_);
+		};
+		::socklen_t length() const noexcept
+		{
+			return this->len_;
+		};
+
+		int family() const noexcept
+		{
+			return this->addr_.ss_family;
+		};
+		int socktype() const noexcept
+		{
+			return this->socktype_;
+		};
+		int protocol() const noexcept
+		{
+			return this->protocol_;
+		};
+
+		/**
+		 * @brief Port in host byte order, 0 for families without one
+		*/
+		uint16_t port() const noexcept
+		{
+			switch (this->family())
+			{
+			case AF_INET:
+				return ntohs(reinterpret_cast<const ::sockaddr_in*>(&this->addr_)->sin_port);
+			case AF_INET6:
+				return ntohs(reinterpret_cast<const ::sockaddr_in6*>(&this->addr_)->sin6_port);
+			default:
+				return 0;
+			};
+		};
+
+		bool operator==(const Endpoint& other) const noexcept
 		{
-			return AddrInfo{};
+			return this->len_ == other.len_ && this->socktype_ == other.socktype_ && this->protocol_ == other.protocol_ &&
+				std::memcmp(&this->addr_, &other.addr_, this->len_) == 0;
 		};
-		return AddrInfo{ _out };
+
+		Endpoint() noexcept = default;
+		Endpoint(const ::sockaddr* _addr, ::socklen_t _len, int _socktype = SOCK_STREAM, int _protocol = 0) noexcept :
+			len_{ std::min(_len, static_cast<::socklen_t>(sizeof(::sockaddr_storage))) },
+			socktype_{ _socktype }, protocol_{ _protocol }
+		{
+			std::memcpy(&this->addr_, _addr, this->len_);
+		};
+		explicit Endpoint(const ::addrinfo& _info) noexcept :
+			Endpoint{ _info.ai_addr, static_cast<::socklen_t>(_info.ai_addrlen), _info.ai_socktype, _info.ai_protocol }
+		{};
+
+	private:
+		::sockaddr_storage addr_{};
+		::socklen_t len_ = 0;
+		int socktype_ = 0;
+		int protocol_ = 0;
 	};
 
-	inline AddrList getaddrinfo(const char* _name, const char* _service)
+	namespace impl
 	{
-		addrinfo* _out{};
-		const auto _result = ::getaddrinfo(_name, _service, nullptr, &_out);
-		if (_result != 0)
+		/**
+		 * @brief IPv6 form of an address used by the RFC 6724 rules, IPv4 is mapped into ::ffff:0:0/96
+		*/
+		using ipv6_bytes = std::array<uint8_t, 16>;
+
+		inline std::optional<ipv6_bytes> to_ipv6_bytes(const ::sockaddr* _addr) noexcept
 		{
-			return AddrInfo{};
+			ipv6_bytes _out{};
+			if (_addr->sa_family == AF_INET6)
+			{
+				std::memcpy(_out.data(), &reinterpret_cast<const ::sockaddr_in6*>(_addr)->sin6_addr, 16);
+				return _out;
+			};
+			if (_addr->sa_family == AF_INET)
+			{
+				_out[10] = 0xFF;
+				_out[11] = 0xFF;
+				std::memcpy(_out.data() + 12, &reinterpret_cast<const ::sockaddr_in*>(_addr)->sin_addr, 4);
+				return _out;
+			};
+			return std::nullopt;
+		};
+
+		inline int common_prefix_length(const ipv6_bytes& _lhs, const ipv6_bytes& _rhs, int _limit = 128) noexcept
+		{
+			int _out = 0;
+			for (size_t n = 0; n != _lhs.size() && _out < _limit; ++n)
+			{
+				const auto _diff = static_cast<uint8_t>(_lhs[n] ^ _rhs[n]);
+				if (_diff != 0)
+				{
+					_out += std::countl_zero(_diff);
+					break;
+				};
+				_out += 8;
+			};
+			return std::min(_out, _limit);
+		};
+
+		/**
+		 * @brief Entry in the RFC 6724 default policy table
+		*/
+		struct address_policy
+		{
+			ipv6_bytes prefix;
+			int prefix_length;
+			int precedence;
+			int label;
+		};
+
+		/**
+		 * @brief RFC 6724 section 2.1 default policy table, longest prefix first
+		*/
+		constexpr inline address_policy address_policies_v[] =
+		{
+			{ { 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,1 }, 128, 50, 0 },
+			{ { 0,0,0,0, 0,0,0,0, 0,0,0xFF,0xFF, 0,0,0,0 }, 96, 35, 4 },
+			{ { 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 96, 1, 3 },
+			{ { 0x20,0x01,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 32, 5, 5 },
+			{ { 0x20,0x02,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 16, 30, 2 },
+			{ { 0x3F,0xFE,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 16, 1, 12 },
+			{ { 0xFE,0xC0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 10, 1, 11 },
+			{ { 0xFC,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 7, 3, 13 },
+			{ { 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 }, 0, 40, 1 },
+		};
+
+		inline const address_policy& lookup_policy(const ipv6_bytes& _addr) noexcept
+		{
+			for (auto& v : address_policies_v)
+			{
+				if (common_prefix_length(_addr, v.prefix, v.prefix_length) == v.prefix_length)
+				{
+					return v;
+				};
+			};
+			return address_policies_v[std::size(address_policies_v) - 1];
+		};
+
+		/**
+		 * @brief Address scope as defined by RFC 6724 section 3.1, 2 link-local, 5 site-local, 14 global
+		*/
+		inline int address_scope(const ipv6_bytes& _addr) noexcept
+		{
+			const bool _mapped = common_prefix_length(_addr, address_policies_v[1].prefix, 96) == 96;
+			if (_mapped)
+			{
+				// Loopback and link-local IPv4 are link-local scope, everything else is global
+				const bool _linkLocal = _addr[12] == 127 || (_addr[12] == 169 && _addr[13] == 254);
+				return (_linkLocal) ? 2 : 14;
+			};
+			if (_addr[0] == 0xFF)
+			{
+				return _addr[1] & 0x0F;
+			};
+			if (_addr == address_policies_v[0].prefix || (_addr[0] == 0xFE && (_addr[1] & 0xC0) == 0x80))
+			{
+				return 2;
+			};
+			if (_addr[0] == 0xFE && (_addr[1] & 0xC0) == 0xC0)
+			{
+				return 5;
+			};
+			return 14;
+		};
+
+		/**
+		 * @brief Source address the kernel would use to reach a destination, found with a connected UDP socket
+		 * @return The source address, nullopt if the destination is unreachable
+		*/
+		inline std::optional<ipv6_bytes> probe_source(const Endpoint& _dest) noexcept
+		{
+			const socket_t _sock = ::socket(_dest.family(), SOCK_DGRAM, IPPROTO_UDP);
+			if (_sock == nullsock)
+			{
+				return std::nullopt;
+			};
+
+			std::optional<ipv6_bytes> _out{};
+			::sockaddr_storage _source{};
+			auto _len = static_cast<::socklen_t>(sizeof(_source));
+			if (::connect(_sock, _dest.get(), _dest.length()) != sockerr &&
+				::getsockname(_sock, reinterpret_cast<::sockaddr*>(&_source), &_len) != sockerr)
+			{
+				_out = to_ipv6_bytes(reinterpret_cast<const ::sockaddr*>(&_source));
+			};
+			close_socket(_sock);
+			return _out;
+		};
+
+		/**
+		 * @brief Orders destinations by RFC 6724 section 6.
+			Rules 1, 2, 5, 6, 8, 9 and 10 are applied. Rules 3, 4 and 7 are skipped because they need interface
+			state, deprecated and temporary address flags and mobile home addresses, which is not queried here.
+		*/
+		inline void sort_destinations(std::vector<Endpoint>& _endpoints)
+		{
+			struct candidate
+			{
+				Endpoint endpoint;
+				std::optional<ipv6_bytes> source;
+				ipv6_bytes address;
+				address_policy policy;
+				int scope;
+			};
+
+			std::vector<candidate> _candidates{};
+			_candidates.reserve(_endpoints.size());
+			for (auto& v : _endpoints)
+			{
+				const auto _address = to_ipv6_bytes(v.get()).value_or(ipv6_bytes{});
+				_candidates.push_back({ v, probe_source(v), _address, lookup_policy(_address), address_scope(_address) });
+			};
+
+			std::stable_sort(_candidates.begin(), _candidates.end(), [](const candidate& a, const candidate& b)
+			{
+				// Rule 1, avoid unusable destinations
+				if (a.source.has_value() != b.source.has_value())
+				{
+					return a.source.has_value();
+				};
+				if (a.source && b.source)
+				{
+					// Rule 2, prefer matching scope
+					const bool _aScope = address_scope(*a.source) == a.scope;
+					const bool _bScope = address_scope(*b.source) == b.scope;
+					if (_aScope != _bScope)
+					{
+						return _aScope;
+					};
+
+					// Rule 5, prefer matching label
+					const bool _aLabel = lookup_policy(*a.source).label == a.policy.label;
+					const bool _bLabel = lookup_policy(*b.source).label == b.policy.label;
+					if (_aLabel != _bLabel)
+					{
+						return _aLabel;
+					};
+				};
+
+				// Rule 6, prefer higher precedence
+				if (a.policy.precedence != b.policy.precedence)
+				{
+					return a.policy.precedence > b.policy.precedence;
+				};
+
+				// Rule 8, prefer smaller scope
+				if (a.scope != b.scope)
+				{
+					return a.scope < b.scope;
+				};
+
+				// Rule 9, prefer the longest matching prefix, IPv6 only
+				if (a.source && b.source && a.endpoint.family() == AF_INET6 && b.endpoint.family() == AF_INET6)
+				{
+					const auto _aPrefix = common_prefix_length(a.address, *a.source, 64);
+					const auto _bPrefix = common_prefix_length(b.address, *b.source, 64);
+					if (_aPrefix != _bPrefix)
+					{
+						return _aPrefix > _bPrefix;
+					};
+				};
+
+				// Rule 10, otherwise leave the order unchanged
+				return false;
+			});
+
+			for (size_t n = 0; n != _endpoints.size(); ++n)
+			{
+				_endpoints[n] = _candidates[n].endpoint;
+			};
+		};
+	};
+
+	/**
+	 * @brief Resolved addresses stored contiguously by value and sorted by RFC 6724 destination preference.
+
+		Copies share one immutable array, so passing the list between caches, pools and threads only
+		touches a reference count. next() hands out entries round-robin, the position is shared by every
+		copy and is safe to advance from any thread.
+	*/
+	struct EndpointList
+	{
+	public:
+		using value_type = Endpoint;
+		using size_type = size_t;
+		using const_iterator = typename std::vector<Endpoint>::const_iterator;
+		using iterator = const_iterator;
+
+		const_iterator begin() const noexcept
+		{
+			return (this->data_) ? this->data_->endpoints.begin() : const_iterator{};
+		};
+		const_iterator end() const noexcept
+		{
+			return (this->data_) ? this->data_->endpoints.end() : const_iterator{};
+		};
+
+		std::span<const Endpoint> span() const noexcept
+		{
+			return (this->data_) ? std::span<const Endpoint>{ this->data_->endpoints } : std::span<const Endpoint>{};
+		};
+		size_type size() const noexcept
+		{
+			return this->span().size();
+		};
+		bool empty() const noexcept
+		{
+			return this->size() == 0;
+		};
+
+		const Endpoint& front() const noexcept
+		{
+			JCLIB_ASSERT(!this->empty());
+			return this->span().front();
+		};
+		const Endpoint& operator[](size_type _index) const noexcept
+		{
+			JCLIB_ASSERT(_index < this->size());
+			return this->span()[_index];
+		};
+
+		/**
+		 * @brief Returns the next endpoint in round-robin order, safe to call from any thread
+		*/
+		const Endpoint& next() const noexcept
+		{
+			JCLIB_ASSERT(!this->empty());
+			const auto _at = this->data_->cursor.fetch_add(1, std::memory_order_relaxed);
+			return this->data_->endpoints[_at % this->data_->endpoints.size()];
+		};
+
+		EndpointList() = default;
+
+		/**
+		 * @brief Copies and sorts a set of endpoints, duplicates are removed
+		 * @param _sort Orders by RFC 6724, which probes each destination with a UDP socket, pass false to keep the given order
+		*/
+		explicit EndpointList(std::vector<Endpoint> _endpoints, bool _sort = true)
+		{
+			std::vector<Endpoint> _unique{};
+			_unique.reserve(_endpoints.size());
+			for (auto& v : _endpoints)
+			{
+				if (std::find(_unique.begin(), _unique.end(), v) == _unique.end())
+				{
+					_unique.push_back(v);
+				};
+			};
+			if (_sort)
+			{
+				impl::sort_destinations(_unique);
+			};
+			this->data_ = std::make_shared<const block>(std::move(_unique));
+		};
+
+		/**
+		 * @brief Flattens a getaddrinfo result
+		 * @param _sort Orders by RFC 6724, pass false to keep the resolver's order
+		*/
+		explicit EndpointList(const AddrList& _list, bool _sort = true) :
+			EndpointList{ flatten(_list), _sort }
+		{};
+
+	private:
+		static std::vector<Endpoint> flatten(const AddrList& _list)
+		{
+			std::vector<Endpoint> _out{};
+			if (!_list.empty())
+			{
+				for (auto& v : _list)
+				{
+					_out.emplace_back(v);
+				};
+			};
+			return _out;
+		};
+
+		struct block
+		{
+			explicit block(std::vector<Endpoint> _endpoints) noexcept :
+				endpoints{ std::move(_endpoints) }
+			{};
+
+			std::vector<Endpoint> endpoints;
+			mutable std::atomic<size_t> cursor{ 0 };
+		};
+
+		std::shared_ptr<const block> data_{};
+	};
+
+
+	namespace impl
+	{
+		/**
+		 * @brief Converts a getaddrinfo return code into a socket error
+		*/
+		inline SocketError convert_gai_error(int _result) noexcept
+		{
+#if defined(CCAP_NET_UNIX)
+			return (_result == EAI_SYSTEM) ? get_error() : ERR_HOSTNOTFOUND;
+#else
+			return SocketError{ adjust_platform_error(_result) };
+#endif
+		};
+
+		inline Result<AddrList> getaddrinfo(const char* _name, const char* _service, const ::addrinfo* _hints) noexcept
+		{
+			addrinfo* _out{};
+			const auto _result = ::getaddrinfo(_name, _service, _hints, &_out);
+			if (_result != 0)
+			{
+				return convert_gai_error(_result);
+			};
+			return AddrList{ AddrInfo{ _out } };
 		};
-		return AddrInfo{ _out };
 	};
 
+	/**
+	 * @brief Resolves a name and service into a list of addresses
+	 * @return The resolved address list, otherwise the resolution error
+	*/
+	inline Result<AddrList> getaddrinfo(const char* _name, const char* _service, const ::addrinfo& _hints) noexcept
+	{
+		return impl::getaddrinfo(_name, _service, &_hints);
+	};
+
+	/**
+	 * @brief Resolves a name and service into a list of addresses
+	 * @return The resolved address list, otherwise the resolution error
+	*/
+	inline Result<AddrList> getaddrinfo(const char* _name, const char* _service) noexcept
+	{
+		return impl::getaddrinfo(_name, _service, nullptr);
+	};
+
+	/**
+	 * @brief Resolves a name and service into a flat endpoint list sorted by RFC 6724 preference
+	 * @return The endpoints, otherwise the resolution error
+	*/
+	inline Result<EndpointList> resolve(const char* _name, const char* _service, const ::addrinfo& _hints)
+	{
+		const auto _list = getaddrinfo(_name, _service, _hints);
+		if (!_list)
+		{
+			return _list.error();
+		};
+		return EndpointList{ *_list };
+	};
+
+	/**
+	 * @brief Resolves a name and service into a flat endpoint list sorted by RFC 6724 preference
+	 * @return The endpoints, otherwise the resolution error
+	*/
+	inline Result<EndpointList> resolve(const char* _name, const char* _service)
+	{
+		::addrinfo _hints{};
+		_hints.ai_socktype = SOCK_STREAM;
+		return resolve(_name, _service, _hints);
+	};
 
-};
\ No newline at end of file
+};
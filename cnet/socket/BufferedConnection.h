@@ -0,0 +1,252 @@
+#pragma once
+
+/*
+	Connection which queues its writes and applies backpressure when the peer is slow.
+
+	write() only queues, the loop calls flush() once per iteration so everything written since the last
+	iteration leaves in one gathered system call. When the queue grows past the high watermark the
+	high callback fires and reads are paused, they resume once it drains to the low watermark. Add
+	events() to the loop's PollSet after each iteration so paused connections stop being read.
+*/
+
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+#include <cnet/socket/PollSet.h>
+#include <cnet/buffer/SendQueue.h>
+#include <cnet/buffer/SharedBuffer.h>
+
+#include <jclib/exception.h>
+
+#include <utility>
+#include <functional>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Queue sizes at which a BufferedConnection applies and releases backpressure
+	*/
+	struct Watermarks
+	{
+		// Queued bytes at or below which reads resume.
+		size_t low = 64 * 1024;
+
+		// Queued bytes above which reads are paused.
+		size_t high = 1024 * 1024;
+	};
+
+	/**
+	 * @brief Owning connected socket with a send queue and watermark based backpressure
+	*/
+	struct BufferedConnection
+	{
+	public:
+		using callback_type = std::function<void(BufferedConnection&)>;
+
+		socket_t socket() const noexcept
+		{
+			return this->sock_;
+		};
+		bool good() const noexcept
+		{
+			return this->sock_ != nullsock;
+		};
+		explicit operator bool() const noexcept
+		{
+			return this->good();
+		};
+
+		const SendQueue& queue() const noexcept
+		{
+			return this->queue_;
+		};
+
+		/**
+		 * @brief Number of bytes written but not yet sent
+		*/
+		size_t queued() const noexcept
+		{
+			return this->queue_.size();
+		};
+
+		/**
+		 * @brief True while the queue is above the high watermark and has not yet drained to the low one
+		*/
+		bool reading_paused() const noexcept
+		{
+			return this->paused_;
+		};
+
+		/**
+		 * @brief PollSet events the loop should watch, read unless paused and write while data is queued
+		*/
+		short events() const noexcept
+		{
+			short _events = 0;
+			if (!this->paused_)
+			{
+				_events |= PollSet::read;
+			};
+			if (!this->queue_.empty())
+			{
+				_events |= PollSet::write;
+			};
+			return _events;
+		};
+
+		/**
+		 * @brief Sets the function called when the queue rises above the high watermark, exceptions it throws leave write()
+		*/
+		void on_high_watermark(callback_type _callback)
+		{
+			this->on_high_ = std::move(_callback);
+		};
+
+		/**
+		 * @brief Sets the function called when the queue drains back to the low watermark, exceptions it throws leave flush()
+		*/
+		void on_low_watermark(callback_type _callback)
+		{
+			this->on_low_ = std::move(_callback);
+		};
+
+		/**
+		 * @brief Queues a copy of the given bytes, nothing is sent until flush()
+		*/
+		void write(const void* _data, size_t _len)
+		{
+			this->queue_.append(_data, _len);
+			this->check_high();
+		};
+
+		/**
+		 * @brief Queues a shared buffer without copying it, nothing is sent until flush()
+		*/
+		void write(SharedBuffer _buffer)
+		{
+			this->queue_.append(std::move(_buffer));
+			this->check_high();
+		};
+
+		/**
+		 * @brief Sends queued bytes with a single gathered write, call once per loop iteration
+		 * @return Number of bytes sent, ERR_WOULDBLOCK if the socket cannot take more yet
+		 * @throws Anything thrown by the low watermark callback
+		*/
+		Result<size_t> flush()
+		{
+			return this->flush(this->queue_.size());
+		};
+
+		/**
+		 * @brief Sends at most the given number of queued bytes with a single gathered write, used for pacing
+		 * @return Number of bytes sent, ERR_WOULDBLOCK if the socket cannot take more yet
+		 * @throws Anything thrown by the low watermark callback
+		*/
+		Result<size_t> flush(size_t _limit)
+		{
+			const auto _result = this->queue_.flush(this->sock_, _limit);
+			if (_result && this->paused_ && this->queue_.size() <= this->marks_.low)
+			{
+				this->paused_ = false;
+				if (this->on_low_)
+				{
+					this->on_low_(*this);
+				};
+			};
+			return _result;
+		};
+
+		/**
+		 * @brief Receives bytes from the peer
+		 * @return Number of bytes received, ERR_WOULDBLOCK if nothing is available or reading is paused
+		*/
+		Result<size_t> read(void* _data, size_t _len) noexcept
+		{
+			if (this->paused_)
+			{
+				return ERR_WOULDBLOCK;
+			};
+			return recv(this->sock_, _data, _len);
+		};
+
+		/**
+		 * @brief Gives up ownership of the socket without closing it, queued bytes are dropped
+		*/
+		socket_t release() noexcept
+		{
+			this->queue_.clear();
+			this->paused_ = false;
+			return std::exchange(this->sock_, nullsock);
+		};
+
+		/**
+		 * @brief Closes the socket, queued bytes are dropped
+		*/
+		void reset() noexcept
+		{
+			if (this->good())
+			{
+				close_socket(this->release());
+			};
+		};
+
+		BufferedConnection() = default;
+		explicit BufferedConnection(socket_t _sock, Watermarks _marks = {}) noexcept :
+			sock_{ _sock }, marks_{ _marks }
+		{
+			JCLIB_ASSERT(this->marks_.low <= this->marks_.high);
+		};
+
+		BufferedConnection(const BufferedConnection&) = delete;
+		BufferedConnection& operator=(const BufferedConnection&) = delete;
+
+		BufferedConnection(BufferedConnection&& other) noexcept :
+			sock_{ std::exchange(other.sock_, nullsock) },
+			queue_{ std::move(other.queue_) },
+			marks_{ other.marks_ },
+			paused_{ std::exchange(other.paused_, false) },
+			on_high_{ std::move(other.on_high_) },
+			on_low_{ std::move(other.on_low_) }
+		{};
+		BufferedConnection& operator=(BufferedConnection&& other) noexcept
+		{
+			if (this != &other)
+			{
+				this->reset();
+				this->sock_ = std::exchange(other.sock_, nullsock);
+				this->queue_ = std::move(other.queue_);
+				this->marks_ = other.marks_;
+				this->paused_ = std::exchange(other.paused_, false);
+				this->on_high_ = std::move(other.on_high_);
+				this->on_low_ = std::move(other.on_low_);
+			};
+			return *this;
+		};
+
+		~BufferedConnection()
+		{
+			this->reset();
+		};
+
+	private:
+		void check_high()
+		{
+			if (!this->paused_ && this->queue_.size() > this->marks_.high)
+			{
+				this->paused_ = true;
+				if (this->on_high_)
+				{
+					this->on_high_(*this);
+				};
+			};
+		};
+
+		socket_t sock_ = nullsock;
+		SendQueue queue_{};
+		Watermarks marks_{};
+		bool paused_ = false;
+		callback_type on_high_{};
+		callback_type on_low_{};
+	};
+
+};
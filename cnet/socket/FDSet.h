@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
 #include <cnet/socket/Socket.h>
 
 #include <jclib/iterator.h>
@@ -11,11 +12,17 @@
 #endif
 
 #include <chrono>
+#include <bit>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <type_traits>
 
 
 
 namespace ccap::net
 {
+#ifdef CCAP_NET_WINDOWS
 	/**
 	 * @brief Minimal wrapper around fd_set giving it STL container semantics
 	*/
@@ -38,6 +45,19 @@ namespace ccap::net
 		{
 			return this->data_.fd_count;
 		};
+		constexpr bool empty() const noexcept
+		{
+			return this->size() == 0;
+		};
+		constexpr size_type capacity() const noexcept
+		{
+			return static_cast<size_type>(FD_SETSIZE);
+		};
+		constexpr void resize(size_type _len) noexcept
+		{
+			JCLIB_ASSERT(_len <= this->capacity());
+			this->data_.fd_count = _len;
+		};
 
 		constexpr pointer data() noexcept
 		{
@@ -58,9 +78,8 @@ namespace ccap::net
 		};
 		constexpr const_iterator cbegin() const noexcept
 		{
-			return this->data();
+			return this->begin();
 		};
-
 		constexpr iterator end() noexcept
 		{
 			return this->begin() + this->size();
@@ -71,17 +90,7 @@ namespace ccap::net
 		};
 		constexpr const_iterator cend() const noexcept
 		{
-			return this->begin() + this->size();
-		};
-
-		constexpr size_type capacity() const noexcept
-		{
-			return static_cast<size_type>(FD_SETSIZE);
-		};
-		constexpr void resize(size_type _len) noexcept
-		{
-			JCLIB_ASSERT(_len <= this->capacity());
-			this->data_.fd_count = _len;
+			return this->end();
 		};
 
 		constexpr reference at(size_type n) noexcept
@@ -104,58 +113,84 @@ namespace ccap::net
 			return this->at(n);
 		};
 
-		constexpr reference front() noexcept
+		constexpr value_type front() const noexcept
 		{
-			return this->at(0);
+			JCLIB_ASSERT(!this->empty());
+			return *this->begin();
 		};
-		constexpr const_reference front() const noexcept
+		constexpr value_type back() const noexcept
 		{
-			return this->at(0);
+			JCLIB_ASSERT(!this->empty());
+			return *(this->end() - 1);
 		};
 
-		constexpr reference back() noexcept
-		{
-			JCLIB_ASSERT(this->size() > 0);
-			return *((this->data() + this->size()) - 1);
-		};
-		constexpr const_reference back() const noexcept
+		/**
+		 * @brief Checks if a socket is in the set, linear as Windows stores sockets in an array
+		*/
+		constexpr bool contains(value_type _sock) const noexcept
 		{
-			JCLIB_ASSERT(this->size() > 0);
-			return *((this->data() + this->size()) - 1);
+			return std::ranges::find(*this, _sock) != this->end();
 		};
 
-		constexpr void insert(value_type _sock, jc::nothrow_t) noexcept
+		constexpr Result<void> insert(value_type _sock, jc::nothrow_t) noexcept
 		{
+			if (this->contains(_sock))
+			{
+				return {};
+			};
 			if (this->size() >= this->capacity())
 			{
 				JCLIB_ABORT();
 			};
-			this->resize(this->size() + 1);
-			this->back() = _sock;
+			this->data_.fd_array[this->data_.fd_count++] = _sock;
+			return {};
 		};
-		constexpr void insert(value_type _sock) noexcept(!JCLIB_EXCEPTIONS)
+		constexpr Result<void> insert(value_type _sock) noexcept(!JCLIB_EXCEPTIONS)
 		{
 			if constexpr (JCLIB_EXCEPTIONS)
 			{
-				if (this->size() >= this->capacity())
+				if (this->size() >= this->capacity() && !this->contains(_sock))
 				{
 					throw std::length_error{ "on FDSet::insert" };
 				};
-				this->resize(this->size() + 1);
-				this->back() = _sock;
-			}
-			else
+			};
+			return this->insert(_sock, jc::nothrow);
+		};
+
+		/**
+		 * @brief Removes a socket by swapping the last socket into its place
+		*/
+		constexpr void erase(value_type _sock) noexcept
+		{
+			auto& _count = this->data_.fd_count;
+			for (decltype(_count) n = 0; n != _count; ++n)
 			{
-				return this->insert(_sock, jc::nothrow);
+				if (this->data_.fd_array[n] == _sock)
+				{
+					this->data_.fd_array[n] = this->data_.fd_array[--_count];
+					return;
+				};
 			};
 		};
 
 		constexpr void clear() noexcept
 		{
-			std::ranges::fill(*this, nullsock);
-			this->resize(0);
+			this->data_.fd_count = 0;
+		};
+
+		/**
+		 * @brief Value to pass as the first argument of select, ignored on Windows
+		*/
+		constexpr int nfds() const noexcept
+		{
+			return 0;
 		};
 
+		/**
+		 * @brief Updates the set after select has modified it, nothing to do on Windows
+		*/
+		constexpr void reserve_nfds(int) noexcept {};
+		constexpr void recount() noexcept {};
 
 		fd_set& as_fdset() noexcept
 		{
@@ -166,9 +201,304 @@ namespace ccap::net
 			return this->data_;
 		};
 
+		constexpr FDSet() noexcept
+		{
+			this->data_.fd_count = 0;
+		};
+
 	private:
 		fd_set data_;
 	};
+#else
+	/**
+	 * @brief Growable bitmap laid out the same as fd_set giving it STL container semantics.
+
+		Insert, erase and contains are O(1) and descriptors beyond FD_SETSIZE are supported.
+		Iteration scans a word at a time skipping empty words, after select only the ready
+		sockets remain in the set.
+	*/
+	struct FDSet
+	{
+	public:
+		using value_type = socket_t;
+		using reference = value_type;
+		using const_reference = value_type;
+
+		using size_type = size_t;
+		using difference_type = std::ptrdiff_t;
+
+		/**
+		 * @brief Bitmap word type, matches the word type used by fd_set
+		*/
+		using word_type = std::make_unsigned_t<::fd_mask>;
+
+		constexpr static size_type word_bits_v = sizeof(word_type) * CHAR_BIT;
+
+		/**
+		 * @brief Iterates over the sockets in the set in ascending order
+		*/
+		struct const_iterator
+		{
+		public:
+			using value_type = socket_t;
+			using reference = value_type;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+
+			constexpr value_type operator*() const noexcept
+			{
+				JCLIB_ASSERT(this->bits_ != 0);
+				return static_cast<value_type>(this->word_ * word_bits_v + std::countr_zero(this->bits_));
+			};
+
+			constexpr const_iterator& operator++() noexcept
+			{
+				JCLIB_ASSERT(this->bits_ != 0);
+				this->bits_ &= this->bits_ - 1;
+				this->skip_empty();
+				return *this;
+			};
+			constexpr const_iterator operator++(int) noexcept
+			{
+				auto _out{ *this };
+				++(*this);
+				return _out;
+			};
+
+			constexpr bool operator==(const const_iterator& other) const noexcept
+			{
+				return this->word_ == other.word_ && this->bits_ == other.bits_;
+			};
+			constexpr bool operator!=(const const_iterator& other) const noexcept
+			{
+				return !(*this == other);
+			};
+
+			constexpr const_iterator() = default;
+			constexpr const_iterator(const word_type* _words, size_type _count, size_type _word) noexcept :
+				words_{ _words }, count_{ _count }, word_{ _word },
+				bits_{ (_word < _count) ? _words[_word] : word_type{} }
+			{
+				this->skip_empty();
+			};
+
+		private:
+			constexpr void skip_empty() noexcept
+			{
+				while (this->bits_ == 0 && this->word_ < this->count_)
+				{
+					++this->word_;
+					this->bits_ = (this->word_ < this->count_) ? this->words_[this->word_] : word_type{};
+				};
+			};
+
+			const word_type* words_ = nullptr;
+			size_type count_ = 0;
+			size_type word_ = 0;
+			word_type bits_ = 0;
+		};
+		using iterator = const_iterator;
+
+		constexpr size_type size() const noexcept
+		{
+			return this->count_;
+		};
+		constexpr bool empty() const noexcept
+		{
+			return this->size() == 0;
+		};
+
+		/**
+		 * @brief Number of descriptors which can be held without growing
+		*/
+		constexpr size_type capacity() const noexcept
+		{
+			return this->words_.size() * word_bits_v;
+		};
+
+		constexpr const_iterator begin() const noexcept
+		{
+			return const_iterator{ this->words_.data(), this->words_.size(), 0 };
+		};
+		constexpr const_iterator cbegin() const noexcept
+		{
+			return this->begin();
+		};
+		constexpr const_iterator end() const noexcept
+		{
+			return const_iterator{ this->words_.data(), this->words_.size(), this->words_.size() };
+		};
+		constexpr const_iterator cend() const noexcept
+		{
+			return this->end();
+		};
+
+		constexpr value_type front() const noexcept
+		{
+			JCLIB_ASSERT(!this->empty());
+			return *this->begin();
+		};
+		/**
+		 * @brief Returns the nth socket in ascending order, linear in the number of words as the set is a bitmap
+		*/
+		constexpr value_type at(size_type n) const noexcept
+		{
+			JCLIB_ASSERT(this->size() > n);
+			size_type _word = 0;
+			auto _bits = this->words_[_word];
+			while (static_cast<size_type>(std::popcount(_bits)) <= n)
+			{
+				n -= static_cast<size_type>(std::popcount(_bits));
+				_bits = this->words_[++_word];
+			};
+			for (; n != 0; --n)
+			{
+				_bits &= _bits - 1;
+			};
+			return static_cast<value_type>(_word * word_bits_v + std::countr_zero(_bits));
+		};
+		constexpr value_type operator[](size_type n) const noexcept
+		{
+			return this->at(n);
+		};
+
+		/**
+		 * @brief The bitmap words, capacity() / word_bits_v of them, laid out as an fd_set
+		*/
+		constexpr const word_type* data() const noexcept
+		{
+			return this->words_.data();
+		};
+
+		constexpr value_type back() const noexcept
+		{
+			JCLIB_ASSERT(!this->empty());
+			auto _word = this->words_.size();
+			while (this->words_[--_word] == 0) {};
+			const auto _bit = word_bits_v - 1 - std::countl_zero(this->words_[_word]);
+			return static_cast<value_type>(_word * word_bits_v + _bit);
+		};
+
+		constexpr bool contains(value_type _sock) const noexcept
+		{
+			const auto _fd = static_cast<size_type>(_sock);
+			return _sock >= 0 && _fd < this->capacity() &&
+				(this->words_[_fd / word_bits_v] & mask(_fd)) != 0;
+		};
+
+		/**
+		 * @brief Adds a socket to the set, aborts if the bitmap cannot grow
+		 * @return ERR_BADF if the socket is negative
+		*/
+		Result<void> insert(value_type _sock, jc::nothrow_t) noexcept
+		{
+			return this->insert_impl(_sock);
+		};
+
+		/**
+		 * @brief Adds a socket to the set
+		 * @return ERR_BADF if the socket is negative
+		 * @throws std::bad_alloc if the bitmap cannot grow
+		*/
+		Result<void> insert(value_type _sock) noexcept(!JCLIB_EXCEPTIONS)
+		{
+			return this->insert_impl(_sock);
+		};
+
+		constexpr void erase(value_type _sock) noexcept
+		{
+			if (this->contains(_sock))
+			{
+				const auto _fd = static_cast<size_type>(_sock);
+				this->words_[_fd / word_bits_v] &= ~mask(_fd);
+				--this->count_;
+			};
+		};
+
+		constexpr void clear() noexcept
+		{
+			std::ranges::fill(this->words_, word_type{});
+			this->count_ = 0;
+		};
+
+		/**
+		 * @brief Value to pass as the first argument of select
+		*/
+		constexpr int nfds() const noexcept
+		{
+			return static_cast<int>(this->capacity());
+		};
+
+		/**
+		 * @brief Grows the bitmap so select can safely read the given number of descriptors
+		 * @throws std::bad_alloc if the bitmap cannot grow
+		*/
+		void reserve_nfds(int _nfds)
+		{
+			const auto _words = (static_cast<size_type>(_nfds) + word_bits_v - 1) / word_bits_v;
+			if (_words > this->words_.size())
+			{
+				this->words_.resize(_words);
+			};
+		};
+
+		/**
+		 * @brief Recomputes the size after select has modified the bitmap
+		*/
+		constexpr void recount() noexcept
+		{
+			size_type _count = 0;
+			for (auto& w : this->words_)
+			{
+				_count += static_cast<size_type>(std::popcount(w));
+			};
+			this->count_ = _count;
+		};
+
+		fd_set& as_fdset() noexcept
+		{
+			JCLIB_ASSERT(!this->words_.empty());
+			return *reinterpret_cast<fd_set*>(this->words_.data());
+		};
+		const fd_set& as_fdset() const noexcept
+		{
+			JCLIB_ASSERT(!this->words_.empty());
+			return *reinterpret_cast<const fd_set*>(this->words_.data());
+		};
+
+		FDSet() = default;
+
+	private:
+		constexpr static word_type mask(size_type _fd) noexcept
+		{
+			return word_type{ 1 } << (_fd % word_bits_v);
+		};
+
+		Result<void> insert_impl(value_type _sock)
+		{
+			if (_sock < 0)
+			{
+				return ERR_BADF;
+			};
+			const auto _fd = static_cast<size_type>(_sock);
+			if (_fd >= this->capacity())
+			{
+				this->words_.resize(std::max(this->words_.size() * 2, _fd / word_bits_v + 1));
+			};
+
+			auto& _word = this->words_[_fd / word_bits_v];
+			if ((_word & mask(_fd)) == 0)
+			{
+				_word |= mask(_fd);
+				++this->count_;
+			};
+			return {};
+		};
+
+		std::vector<word_type> words_{};
+		size_type count_ = 0;
+	};
+#endif
 
 
 
@@ -218,15 +548,78 @@ namespace ccap::net
 
 
 
-	inline int select(int _flags, FDSet* _read, FDSet* _write, FDSet* _excepts, const ::timeval& _timeout)
+	namespace impl
+	{
+		/**
+		 * @brief Sizes each set for select and returns the nfds argument to use
+		*/
+		inline int prepare_select(int _nfds, FDSet* _read, FDSet* _write, FDSet* _excepts)
+		{
+			for (auto v : { _read, _write, _excepts })
+			{
+				if (v)
+				{
+					_nfds = std::max(_nfds, v->nfds());
+				};
+			};
+			for (auto v : { _read, _write, _excepts })
+			{
+				if (v && !v->empty())
+				{
+					v->reserve_nfds(_nfds);
+				};
+			};
+			return _nfds;
+		};
+
+		inline Result<int> select(int _nfds, FDSet* _read, FDSet* _write, FDSet* _excepts, ::timeval* _timeout)
+		{
+			auto& _get = impl::get_fdset;
+			_nfds = prepare_select(_nfds, _read, _write, _excepts);
+			const auto _result = ::select(_nfds, _get(_read), _get(_write), _get(_excepts), _timeout);
+			if (_result == sockerr)
+			{
+				return get_error();
+			};
+			for (auto v : { _read, _write, _excepts })
+			{
+				if (v && !v->empty())
+				{
+					v->recount();
+				};
+			};
+			return _result;
+		};
+	};
+
+	/**
+	 * @brief Waits for sockets in the given sets to become ready, only the ready sockets are left in each set
+	 * @param _flags Highest descriptor plus one, raised to cover the given sets if needed
+	 * @return Number of ready sockets, 0 on timeout, otherwise the socket error
+	 * @throws std::bad_alloc if a set cannot grow to cover the descriptors being waited on
+	*/
+	inline Result<int> select(int _flags, FDSet* _read, FDSet* _write, FDSet* _excepts, const ::timeval& _timeout)
+	{
+		auto _timeoutCopy = _timeout;
+		return impl::select(_flags, _read, _write, _excepts, &_timeoutCopy);
+	};
+	inline Result<int> select(int _flags, FDSet* _read, FDSet* _write, FDSet* _excepts)
+	{
+		return impl::select(_flags, _read, _write, _excepts, nullptr);
+	};
+
+	/**
+	 * @brief Waits for sockets in the given sets to become ready, only the ready sockets are left in each set
+	 * @return Number of ready sockets, 0 on timeout, otherwise the socket error
+	 * @throws std::bad_alloc if a set cannot grow to cover the descriptors being waited on
+	*/
+	inline Result<int> select(FDSet* _read, FDSet* _write, FDSet* _excepts, const ::timeval& _timeout)
 	{
-		auto& _get = impl::get_fdset;
-		return ::select(_flags, _get(_read), _get(_write), _get(_excepts), &_timeout);
+		return select(0, _read, _write, _excepts, _timeout);
 	};
-	inline int select(int _flags, FDSet* _read, FDSet* _write, FDSet* _excepts)
+	inline Result<int> select(FDSet* _read, FDSet* _write, FDSet* _excepts)
 	{
-		auto& _get = impl::get_fdset;
-		return ::select(_flags, _get(_read), _get(_write), _get(_excepts), nullptr);
+		return select(0, _read, _write, _excepts);
 	};
 
 
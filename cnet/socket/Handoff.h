@@ -0,0 +1,407 @@
+#pragma once
+
+/*
+	Hands listening sockets from a running process to its replacement for zero-downtime restarts.
+
+	The old process listens on a Unix seqpacket socket. When the new process connects its credentials are
+	checked against the expected HandoffPeer and, if they match, it is sent the names of every listener
+	together with the listening descriptors via SCM_RIGHTS. The new process acknowledges once it holds
+	them, then the old process stops accepting, closes its copies, drains its existing connections and
+	exits. Both processes share the same kernel listening sockets the whole time, so the accept queue is
+	never closed and no SYNs are dropped.
+
+	Only available when CCAP_NET_UNIX is defined.
+*/
+
+#include <cnet/socket/UnixSocket.h>
+
+#ifdef CCAP_NET_UNIX
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <span>
+#include <chrono>
+#include <climits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <string_view>
+
+namespace ccap::net
+{
+	/**
+	 * @brief A listening socket offered for handoff, the name lets the new process tell them apart
+	*/
+	struct HandoffListener
+	{
+		std::string_view name;
+		socket_t socket = nullsock;
+	};
+
+	/**
+	 * @brief Credentials a connecting process must have to be handed the listeners
+	*/
+	struct HandoffPeer
+	{
+		// User the new process must run as, defaults to the current effective user.
+		::uid_t uid = ::geteuid();
+
+		// Process id the new process must have, 0 accepts any process run by uid.
+		::pid_t pid = 0;
+	};
+
+	/**
+	 * @brief Listening sockets received from the previous process
+	*/
+	struct InheritedListeners
+	{
+	public:
+		struct value_type
+		{
+			std::string name;
+			socket_t socket = nullsock;
+		};
+
+		using iterator = typename std::vector<value_type>::const_iterator;
+
+		iterator begin() const noexcept
+		{
+			return this->listeners_.begin();
+		};
+		iterator end() const noexcept
+		{
+			return this->listeners_.end();
+		};
+		size_t size() const noexcept
+		{
+			return this->listeners_.size();
+		};
+		bool empty() const noexcept
+		{
+			return this->listeners_.empty();
+		};
+
+		/**
+		 * @brief Finds a listener by the name it was offered under
+		 * @return The listening socket, nullopt if the previous process did not offer one by that name
+		*/
+		std::optional<socket_t> find(std::string_view _name) const noexcept
+		{
+			for (auto& v : this->listeners_)
+			{
+				if (v.name == _name)
+				{
+					return v.socket;
+				};
+			};
+			return std::nullopt;
+		};
+
+		void push_back(value_type _value)
+		{
+			this->listeners_.push_back(std::move(_value));
+		};
+
+		InheritedListeners() = default;
+
+	private:
+		std::vector<value_type> listeners_{};
+	};
+
+	namespace impl
+	{
+		/**
+		 * @brief Byte sent by the new process once it holds the listeners
+		*/
+		constexpr inline char handoff_ack_v = 'A';
+
+		/**
+		 * @brief Largest handoff message accepted, bounds the listener name table
+		*/
+		constexpr inline size_t handoff_max_message_v = 64 * 1024;
+
+		inline void append_u16(std::vector<char>& _buffer, uint16_t _value)
+		{
+			const char _bytes[2] = { static_cast<char>(_value & 0xFF), static_cast<char>(_value >> 8) };
+			_buffer.insert(_buffer.end(), _bytes, _bytes + 2);
+		};
+		inline uint16_t read_u16(const char* _at) noexcept
+		{
+			return static_cast<uint16_t>(static_cast<unsigned char>(_at[0]) | (static_cast<unsigned char>(_at[1]) << 8));
+		};
+
+		inline void close_all(std::span<const socket_t> _fds) noexcept
+		{
+			for (auto& v : _fds)
+			{
+				close_socket(v);
+			};
+		};
+
+		/**
+		 * @brief Checks the credentials of a connected Unix socket's peer
+		 * @return Empty result if they match, ERR_ACCES if they do not, otherwise the socket error
+		*/
+		inline Result<void> check_peer(socket_t _sock, const HandoffPeer& _expected) noexcept
+		{
+#ifdef SO_PEERCRED
+			::ucred _cred{};
+			::socklen_t _len = sizeof(_cred);
+			if (::getsockopt(_sock, SOL_SOCKET, SO_PEERCRED, &_cred, &_len) == sockerr)
+			{
+				return get_error();
+			};
+			if (_cred.uid != _expected.uid || (_expected.pid != 0 && _cred.pid != _expected.pid))
+			{
+				return ERR_ACCES;
+			};
+#else
+			// No portable way to read the peer's pid here, only the user can be checked
+			::uid_t _uid{};
+			::gid_t _gid{};
+			if (::getpeereid(_sock, &_uid, &_gid) == sockerr)
+			{
+				return get_error();
+			};
+			if (_uid != _expected.uid || _expected.pid != 0)
+			{
+				return ERR_ACCES;
+			};
+#endif
+			return {};
+		};
+
+		/**
+		 * @brief Time left until a deadline, never negative
+		*/
+		inline std::chrono::milliseconds remaining(std::chrono::steady_clock::time_point _deadline) noexcept
+		{
+			const auto _left = std::chrono::ceil<std::chrono::milliseconds>(_deadline - std::chrono::steady_clock::now());
+			return std::max(_left, std::chrono::milliseconds::zero());
+		};
+
+		/**
+		 * @brief Waits until a socket is readable or the deadline passes
+		 * @return Empty result once readable, ERR_TIMEDOUT at the deadline, otherwise the socket error
+		*/
+		inline Result<void> wait_readable(socket_t _sock, std::chrono::steady_clock::time_point _deadline) noexcept
+		{
+			::pollfd _fd{};
+			_fd.fd = _sock;
+			_fd.events = POLLIN;
+			const auto _ms = std::min<std::chrono::milliseconds::rep>(impl::remaining(_deadline).count(), INT_MAX);
+			const auto _ready = ::poll(&_fd, 1, static_cast<int>(_ms));
+			if (_ready == sockerr)
+			{
+				return get_error();
+			};
+			if (_ready == 0)
+			{
+				return ERR_TIMEDOUT;
+			};
+			return {};
+		};
+	};
+
+	/**
+	 * @brief Creates the socket the old process offers its listeners on
+	 * @param _address Handoff address. Abstract names leave no stale file after a crash but have no filesystem
+		permissions, any local process may connect to them, so serve_handoff checks the peer's credentials.
+	 * @return The handoff listening socket, otherwise the socket error
+	*/
+	inline Result<socket_t> new_handoff_listener(const UnixAddress& _address) noexcept
+	{
+		return new_listener(_address, 1, UnixSocketType::seqpacket);
+	};
+
+	/**
+	 * @brief Old process side, accepts the new process and sends it every listener.
+
+		Connecting processes whose credentials do not match _expected are closed without being sent anything
+		and the wait continues. Returns once the new process has acknowledged, at which point the old process
+		should stop calling accept, close its copies of the listeners and drain its existing connections. On
+		failure the old process still owns the listeners and should keep serving.
+
+	 * @param _handoff Socket from new_handoff_listener
+	 * @param _listeners Listening sockets to hand over, at most max_passed_fds_v
+	 * @param _timeout How long to wait for the new process to connect and acknowledge
+	 * @param _expected Credentials the new process must have
+	 * @return Empty result once acknowledged, ERR_TIMEDOUT if no matching process acknowledged in time, otherwise the socket error
+	*/
+	inline Result<void> serve_handoff(socket_t _handoff, std::span<const HandoffListener> _listeners, std::chrono::milliseconds _timeout,
+		const HandoffPeer& _expected = {})
+	{
+		const auto _deadline = std::chrono::steady_clock::now() + _timeout;
+
+		if (_listeners.empty() || _listeners.size() > max_passed_fds_v)
+		{
+			return ERR_INVAL;
+		};
+
+		std::vector<char> _message{};
+		std::vector<socket_t> _fds{};
+		_fds.reserve(_listeners.size());
+
+		impl::append_u16(_message, static_cast<uint16_t>(_listeners.size()));
+		for (auto& v : _listeners)
+		{
+			if (v.name.size() > UINT16_MAX)
+			{
+				return ERR_NAMETOOLONG;
+			};
+			impl::append_u16(_message, static_cast<uint16_t>(v.name.size()));
+			_message.insert(_message.end(), v.name.begin(), v.name.end());
+			_fds.push_back(v.socket);
+		};
+		if (_message.size() > impl::handoff_max_message_v)
+		{
+			return ERR_MSGSIZE;
+		};
+
+		// Accept until a process with the expected credentials connects
+		auto _peer = nullsock;
+		while (_peer == nullsock)
+		{
+			const auto _readable = impl::wait_readable(_handoff, _deadline);
+			if (!_readable)
+			{
+				return _readable.error();
+			};
+			_peer = ::accept(_handoff, nullptr, nullptr);
+			if (_peer == nullsock)
+			{
+				return get_error();
+			};
+			if (!impl::check_peer(_peer, _expected))
+			{
+				close_socket(std::exchange(_peer, nullsock));
+			};
+		};
+
+		auto _sent = send_fds(_peer, _message.data(), _message.size(), _fds);
+		if (!_sent)
+		{
+			close_socket(_peer);
+			return _sent.error();
+		};
+
+		const auto _acked = impl::wait_readable(_peer, _deadline);
+		if (!_acked)
+		{
+			close_socket(_peer);
+			return _acked.error();
+		};
+
+		char _ack{};
+		const auto _received = ::recv(_peer, &_ack, 1, 0);
+		const auto _err = (_received == sockerr) ? get_error() : ERR_NONE;
+		close_socket(_peer);
+
+		if (_err != ERR_NONE)
+		{
+			return _err;
+		};
+		if (_received != 1 || _ack != impl::handoff_ack_v)
+		{
+			return ERR_CONNABORTED;
+		};
+		return {};
+	};
+
+	/**
+	 * @brief New process side, connects to the old process and takes over its listeners.
+		Fails to connect if no old process is offering a handoff, ERR_CONNREFUSED for an abstract address,
+		in which case the caller should create fresh listeners with new_listener.
+	 * @param _address Handoff address the old process is listening on
+	 * @param _timeout How long to wait for the old process to send its listeners
+	 * @return The inherited listeners, ERR_TIMEDOUT if none arrived in time, otherwise the socket error
+	*/
+	inline Result<InheritedListeners> request_handoff(const UnixAddress& _address, std::chrono::milliseconds _timeout)
+	{
+		const auto _deadline = std::chrono::steady_clock::now() + _timeout;
+
+		auto _sock = connect(_address, UnixSocketType::seqpacket);
+		if (!_sock)
+		{
+			return _sock.error();
+		};
+
+		// Closes the handoff socket, and the received listeners until they are returned, on every exit including throws
+		struct cleanup
+		{
+			socket_t sock;
+			std::span<const socket_t> fds{};
+			~cleanup()
+			{
+				impl::close_all(this->fds);
+				close_socket(this->sock);
+			};
+		} _cleanup{ *_sock };
+
+		std::vector<char> _message(impl::handoff_max_message_v);
+		socket_t _fds[max_passed_fds_v]{};
+
+		const auto _readable = impl::wait_readable(*_sock, _deadline);
+		if (!_readable)
+		{
+			return _readable.error();
+		};
+		const auto _received = recv_fds(*_sock, _message.data(), _message.size(), _fds);
+		if (!_received)
+		{
+			return _received.error();
+		};
+		_cleanup.fds = std::span<const socket_t>{ _fds, _received->count };
+
+		// Parse the name table, every name must line up with a received descriptor
+		const auto _bytes = _received->bytes;
+		if (_received->truncated || _bytes < 2)
+		{
+			return ERR_MSGSIZE;
+		};
+
+		const auto _count = impl::read_u16(_message.data());
+		if (_count != _received->count)
+		{
+			return ERR_INVAL;
+		};
+
+		InheritedListeners _out{};
+		size_t _at = 2;
+		for (size_t n = 0; n != _count; ++n)
+		{
+			if (_at + 2 > _bytes)
+			{
+				return ERR_MSGSIZE;
+			};
+			const auto _len = impl::read_u16(_message.data() + _at);
+			_at += 2;
+			if (_at + _len > _bytes)
+			{
+				return ERR_MSGSIZE;
+			};
+			_out.push_back({ std::string{ _message.data() + _at, _len }, _fds[n] });
+			_at += _len;
+		};
+
+		// Tell the old process it can stop accepting
+		const auto _ack = impl::handoff_ack_v;
+		if (::send(*_sock, &_ack, 1, impl::send_flags_v) != 1)
+		{
+			const auto _err = get_error();
+			return (_err == ERR_NONE) ? ERR_CONNABORTED : _err;
+		};
+
+		_cleanup.fds = {};
+		return _out;
+	};
+
+};
+
+#endif
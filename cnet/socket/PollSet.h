@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
+
+#include <jclib/iterator.h>
+
+#include <chrono>
+#include <vector>
+#include <iterator>
+#include <unordered_map>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Readiness set backed by a dense pollfd array, a portable alternative to FDSet with no FD_SETSIZE limit.
+
+		Sockets are kept contiguous so poll is handed a single array, erase swaps the last entry into the
+		hole so it stays O(1). After poll() only the ready entries are visited through ready().
+	*/
+	struct PollSet
+	{
+	public:
+		using value_type = ::pollfd;
+		using size_type = size_t;
+
+		/**
+		 * @brief Event flags which can be passed to insert and modify
+		*/
+		constexpr static short read = POLLIN;
+		constexpr static short write = POLLOUT;
+
+		/**
+		 * @brief Range over the entries reported ready by the last call to poll
+		*/
+		struct ready_range
+		{
+		public:
+			struct iterator
+			{
+			public:
+				using value_type = ::pollfd;
+				using reference = const value_type&;
+				using pointer = const value_type*;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::forward_iterator_tag;
+
+				reference operator*() const noexcept
+				{
+					return *this->at_;
+				};
+				pointer operator->() const noexcept
+				{
+					return this->at_;
+				};
+
+				iterator& operator++() noexcept
+				{
+					--this->remaining_;
+					++this->at_;
+					this->skip_idle();
+					return *this;
+				};
+				iterator operator++(int) noexcept
+				{
+					auto _out{ *this };
+					++(*this);
+					return _out;
+				};
+
+				bool operator==(const iterator& other) const noexcept
+				{
+					return this->remaining_ == other.remaining_;
+				};
+				bool operator!=(const iterator& other) const noexcept
+				{
+					return !(*this == other);
+				};
+
+				iterator() = default;
+				iterator(pointer _at, pointer _end, size_type _remaining) noexcept :
+					at_{ _at }, end_{ _end }, remaining_{ _remaining }
+				{
+					this->skip_idle();
+				};
+
+			private:
+				void skip_idle() noexcept
+				{
+					if (this->remaining_ == 0)
+					{
+						return;
+					};
+					while (this->at_ != this->end_ && this->at_->revents == 0)
+					{
+						++this->at_;
+					};
+					if (this->at_ == this->end_)
+					{
+						this->remaining_ = 0;
+					};
+				};
+
+				pointer at_ = nullptr;
+				pointer end_ = nullptr;
+				size_type remaining_ = 0;
+			};
+
+			iterator begin() const noexcept
+			{
+				return iterator{ this->data_, this->data_ + this->size_, this->ready_ };
+			};
+			iterator end() const noexcept
+			{
+				return iterator{};
+			};
+
+			/**
+			 * @brief Number of ready entries
+			*/
+			size_type size() const noexcept
+			{
+				return this->ready_;
+			};
+			bool empty() const noexcept
+			{
+				return this->size() == 0;
+			};
+
+			ready_range(const value_type* _data, size_type _size, size_type _ready) noexcept :
+				data_{ _data }, size_{ _size }, ready_{ _ready }
+			{};
+
+		private:
+			const value_type* data_;
+			size_type size_;
+			size_type ready_;
+		};
+
+		size_type size() const noexcept
+		{
+			return this->fds_.size();
+		};
+		bool empty() const noexcept
+		{
+			return this->fds_.empty();
+		};
+		void reserve(size_type _count)
+		{
+			this->fds_.reserve(_count);
+			this->index_.reserve(_count);
+		};
+
+		const value_type* data() const noexcept
+		{
+			return this->fds_.data();
+		};
+
+		bool contains(socket_t _sock) const noexcept
+		{
+			return this->index_.contains(_sock);
+		};
+
+		/**
+		 * @brief Adds a socket, or replaces its events if it is already in the set
+		 * @param _events Combination of PollSet::read and PollSet::write
+		*/
+		void insert(socket_t _sock, short _events)
+		{
+			const auto _it = this->index_.find(_sock);
+			if (_it != this->index_.end())
+			{
+				this->fds_[_it->second].events = _events;
+				return;
+			};
+
+			value_type _fd{};
+			_fd.fd = _sock;
+			_fd.events = _events;
+			this->fds_.push_back(_fd);
+
+			// Drops the new entry again if the index throws, so every index entry always points into fds_
+			struct rollback
+			{
+				std::vector<value_type>* fds;
+				~rollback()
+				{
+					if (this->fds)
+					{
+						this->fds->pop_back();
+					};
+				};
+			} _rollback{ &this->fds_ };
+			this->index_.emplace(_sock, this->fds_.size() - 1);
+			_rollback.fds = nullptr;
+		};
+
+		/**
+		 * @brief Replaces the events watched for a socket already in the set
+		 * @return False if the socket is not in the set
+		*/
+		bool modify(socket_t _sock, short _events) noexcept
+		{
+			const auto _it = this->index_.find(_sock);
+			if (_it == this->index_.end())
+			{
+				return false;
+			};
+			this->fds_[_it->second].events = _events;
+			return true;
+		};
+
+		/**
+		 * @brief Removes a socket by moving the last entry into its slot
+		 * @return False if the socket is not in the set
+		*/
+		bool erase(socket_t _sock) noexcept
+		{
+			const auto _it = this->index_.find(_sock);
+			if (_it == this->index_.end())
+			{
+				return false;
+			};
+
+			const auto _pos = _it->second;
+			this->index_.erase(_it);
+			if (_pos != this->fds_.size() - 1)
+			{
+				this->fds_[_pos] = this->fds_.back();
+				this->index_[this->fds_[_pos].fd] = _pos;
+			};
+			this->fds_.pop_back();
+			this->ready_ = 0;
+			return true;
+		};
+
+		void clear() noexcept
+		{
+			this->fds_.clear();
+			this->index_.clear();
+			this->ready_ = 0;
+		};
+
+		/**
+		 * @brief Waits for any socket in the set to become ready
+		 * @param _timeout Maximum time to wait, zero returns immediately
+		 * @return Number of ready sockets, 0 on timeout, otherwise the socket error
+		*/
+		Result<int> poll(std::chrono::milliseconds _timeout) noexcept
+		{
+			return this->poll_impl(static_cast<int>(_timeout.count()));
+		};
+
+		/**
+		 * @brief Waits indefinitely for any socket in the set to become ready
+		 * @return Number of ready sockets, otherwise the socket error
+		*/
+		Result<int> poll() noexcept
+		{
+			return this->poll_impl(-1);
+		};
+
+		/**
+		 * @brief Returns the entries reported ready by the last call to poll, invalidated by insert and erase
+		*/
+		ready_range ready() const noexcept
+		{
+			return ready_range{ this->fds_.data(), this->fds_.size(), this->ready_ };
+		};
+
+		PollSet() = default;
+
+	private:
+		Result<int> poll_impl(int _timeoutMs) noexcept
+		{
+#ifdef CCAP_NET_WINDOWS
+			const auto _result = ::WSAPoll(this->fds_.data(), static_cast<ULONG>(this->fds_.size()), _timeoutMs);
+#else
+			const auto _result = ::poll(this->fds_.data(), static_cast<::nfds_t>(this->fds_.size()), _timeoutMs);
+#endif
+			if (_result == sockerr)
+			{
+				this->ready_ = 0;
+				return get_error();
+			};
+			this->ready_ = static_cast<size_type>(_result);
+			return _result;
+		};
+
+		std::vector<value_type> fds_{};
+		std::unordered_map<socket_t, size_type> index_{};
+		size_type ready_ = 0;
+	};
+
+};
@@ -1,134 +1,540 @@
 #pragma once
 
 #include <cnet/platform/SocketLib.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
+#include <cnet/socket/SocketOption.h>
 #include "AddrInfo.h"
 
 #include <memory>
 
 namespace ccap::net
 {
-#ifdef CCAP_NET_WINDOWS
-	/**
-	 * @brief Platform socket type alias
-	*/
-	using socket_t = ::SOCKET;
-#else
-	/**
-	 * @brief Platform socket type alias
-	*/
-	using socket_t = int;
-#endif
-
-#ifdef CCAP_NET_WINDOWS
-	/**
-	 * @brief Platform-independent null socket value
-	*/
-	constexpr inline socket_t nullsock = INVALID_SOCKET;
-	constexpr inline int sockerr = SOCKET_ERROR;
-#else
-	/**
-	 * @brief Platform-independent null socket value
-	*/
-	constexpr inline socket_t nullsock = -1;
-	constexpr inline int sockerr = -1;
-#endif
-
 	struct AddrList;
 
 	/**
 	 * @brief Attempts to connect to an address returned from getaddrinfo
 	 * @param _address Address list
-	 * @return The connected socket if succesfull, otherwise invalid socket
+	 * @param _opts Socket options applied before connecting
+	 * @return The connected socket, otherwise the error from the last address tried
 	*/
-	inline socket_t connect(const AddrList& _address)
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> connect(const AddrList& _address, const SocketOptions<Ts...>& _opts) noexcept
 	{
-		socket_t _sock = nullsock;
+		SocketError _err = ERR_ADDRNOTAVAIL;
 		for (auto& addr : _address)
 		{
-			_sock = ::socket(addr.ai_family, addr.ai_socktype, addr.ai_protocol);
+			const socket_t _sock = ::socket(addr.ai_family, addr.ai_socktype, addr.ai_protocol);
 			if (_sock == nullsock)
 			{
-				return nullsock;
+				_err = get_error();
+				continue;
 			};
 
-			const auto _result = ::connect(_sock, addr.ai_addr, addr.ai_addrlen);
-			if (_result == sockerr)
+			_err = set_options(_sock, _opts).error();
+			if (_err == ERR_NONE)
 			{
-				const auto _result = ::closesocket(_sock);
-				if (_result == sockerr)
+				const auto _result = ::connect(_sock, addr.ai_addr, addr.ai_addrlen);
+				if (_result != sockerr)
 				{
-					return nullsock;
+					return _sock;
 				};
-
-				_sock = nullsock;
-				continue;
+				_err = get_error();
 			};
+
+			close_socket(_sock);
 		};
-		return _sock;
+		return _err;
+	};
+
+	/**
+	 * @brief Attempts to connect to an address returned from getaddrinfo
+	 * @param _address Address list
+	 * @return The connected socket, otherwise the error from the last address tried
+	*/
+	inline Result<socket_t> connect(const AddrList& _address) noexcept
+	{
+		return connect(_address, presets::none);
 	};
 
 	/**
 	 * @brief Attempts to connect to an address returned from getaddrinfo
 	 * @param _address Address name
 	 * @param _service Service name, usually port number
-	 * @return The connected socket if succesful, otherwise invalid socket
+	 * @param _opts Socket options applied before connecting
+	 * @return The connected socket, otherwise the resolution or connection error
 	*/
-	inline socket_t connect(const char* _address, const char* _service, ::addrinfo* _hints = nullptr)
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> connect(const char* _address, const char* _service, const SocketOptions<Ts...>& _opts, ::addrinfo* _hints = nullptr) noexcept
 	{
 		const auto _addrList = (_hints)? getaddrinfo(_address, _service, *_hints) : getaddrinfo(_address, _service);
-		return connect(_addrList);
+		if (!_addrList)
+		{
+			return _addrList.error();
+		};
+		return connect(*_addrList, _opts);
 	};
 
+	/**
+	 * @brief Attempts to connect to an address returned from getaddrinfo
+	 * @param _address Address name
+	 * @param _service Service name, usually port number
+	 * @return The connected socket, otherwise the resolution or connection error
+	*/
+	inline Result<socket_t> connect(const char* _address, const char* _service, ::addrinfo* _hints = nullptr) noexcept
+	{
+		return connect(_address, _service, presets::none, _hints);
+	};
 
+	/**
+	 * @brief Connects to a single resolved endpoint
+	 * @param _endpoint Address to connect to
+	 * @param _opts Socket options applied before connecting
+	 * @return The connected socket, otherwise the connection error
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> connect(const Endpoint& _endpoint, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		const socket_t _sock = ::socket(_endpoint.family(), (_endpoint.socktype() != 0) ? _endpoint.socktype() : SOCK_STREAM, _endpoint.protocol());
+		if (_sock == nullsock)
+		{
+			return get_error();
+		};
 
+		auto _err = set_options(_sock, _opts).error();
+		if (_err == ERR_NONE)
+		{
+			if (::connect(_sock, _endpoint.get(), _endpoint.length()) != sockerr)
+			{
+				return _sock;
+			};
+			_err = get_error();
+		};
+
+		close_socket(_sock);
+		return _err;
+	};
 
-	inline socket_t new_listener(const char* _address, const char* _service, int _backlog, ::addrinfo* _hints = nullptr)
+	/**
+	 * @brief Connects to a single resolved endpoint
+	 * @param _endpoint Address to connect to
+	 * @return The connected socket, otherwise the connection error
+	*/
+	inline Result<socket_t> connect(const Endpoint& _endpoint) noexcept
 	{
-		socket_t _sock{};
+		return connect(_endpoint, presets::none);
+	};
 
-		auto _addrList = (_hints) ? getaddrinfo(_address, _service, *_hints) : getaddrinfo(_address, _service);
-		for (auto& v : _addrList)
+	/**
+	 * @brief Tries each endpoint in preference order until one connects
+	 * @param _endpoints Endpoint list
+	 * @param _opts Socket options applied before connecting
+	 * @return The connected socket, otherwise the error from the last endpoint tried
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> connect(const EndpointList& _endpoints, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		SocketError _err = ERR_ADDRNOTAVAIL;
+		for (auto& v : _endpoints)
 		{
-			_sock = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-			if (_sock != net::nullsock)
+			const auto _sock = connect(v, _opts);
+			if (_sock)
 			{
-				const auto _error = ::bind(_sock, v.ai_addr, v.ai_addrlen);
-				if (_error == (int)net::ERR_NONE)
-				{
-					break;
-				};
+				return _sock;
 			};
+			_err = _sock.error();
+		};
+		return _err;
+	};
 
-			const auto _closeError = ::closesocket(_sock);
-			if (_closeError != (int)net::ERR_NONE)
+	/**
+	 * @brief Tries each endpoint in preference order until one connects
+	 * @param _endpoints Endpoint list
+	 * @return The connected socket, otherwise the error from the last endpoint tried
+	*/
+	inline Result<socket_t> connect(const EndpointList& _endpoints) noexcept
+	{
+		return connect(_endpoints, presets::none);
+	};
+
+
+
+	/**
+	 * @brief Creates a socket bound to the given address and starts listening on it
+	 * @param _address Address name
+	 * @param _service Service name, usually port number
+	 * @param _backlog Maximum length of the pending connection queue
+	 * @param _opts Socket options applied before listening, accepted sockets inherit most of these
+	 * @return The listening socket, otherwise the error from the last address tried
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> new_listener(const char* _address, const char* _service, int _backlog, const SocketOptions<Ts...>& _opts, ::addrinfo* _hints = nullptr) noexcept
+	{
+		const auto _addrList = (_hints) ? getaddrinfo(_address, _service, *_hints) : getaddrinfo(_address, _service);
+		if (!_addrList)
+		{
+			return _addrList.error();
+		};
+
+		SocketError _err = ERR_ADDRNOTAVAIL;
+		for (auto& v : *_addrList)
+		{
+			const socket_t _sock = ::socket(v.ai_family, (v.ai_socktype != 0) ? v.ai_socktype : SOCK_STREAM, v.ai_protocol);
+			if (_sock == net::nullsock)
 			{
+				_err = get_error();
 				continue;
 			};
+
+			_err = set_options(_sock, _opts).error();
+			if (_err == ERR_NONE)
+			{
+				if (::bind(_sock, v.ai_addr, v.ai_addrlen) != net::sockerr &&
+					::listen(_sock, _backlog) != net::sockerr)
+				{
+					return _sock;
+				};
+				_err = get_error();
+			};
+
+			close_socket(_sock);
+		};
+
+		return _err;
+	};
+
+	/**
+	 * @brief Creates a socket bound to the given address and starts listening on it
+	 * @param _address Address name
+	 * @param _service Service name, usually port number
+	 * @param _backlog Maximum length of the pending connection queue
+	 * @return The listening socket, otherwise the error from the last address tried
+	*/
+	inline Result<socket_t> new_listener(const char* _address, const char* _service, int _backlog, ::addrinfo* _hints = nullptr) noexcept
+	{
+		return new_listener(_address, _service, _backlog, presets::none, _hints);
+	};
+
+
+	/**
+	 * @brief Creates a datagram socket bound to the given address
+	 * @param _address Address name, nullptr binds the wildcard address
+	 * @param _service Service name, usually port number
+	 * @param _opts Socket options applied before binding
+	 * @return The bound socket, otherwise the error from the last address tried
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> new_datagram_socket(const char* _address, const char* _service, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		::addrinfo _hints{};
+		_hints.ai_socktype = SOCK_DGRAM;
+		_hints.ai_flags = AI_PASSIVE;
+
+		const auto _addrList = getaddrinfo(_address, _service, _hints);
+		if (!_addrList)
+		{
+			return _addrList.error();
 		};
 
-		if (_sock != net::nullsock)
+		SocketError _err = ERR_ADDRNOTAVAIL;
+		for (auto& v : *_addrList)
 		{
-			const auto _result = ::listen(_sock, _backlog);
-			if (_result == net::sockerr) [[unlikely]]
+			const socket_t _sock = ::socket(v.ai_family, v.ai_socktype, v.ai_protocol);
+			if (_sock == net::nullsock)
 			{
-				return nullsock;
+				_err = get_error();
+				continue;
 			};
+
+			_err = set_options(_sock, _opts).error();
+			if (_err == ERR_NONE)
+			{
+				if (::bind(_sock, v.ai_addr, v.ai_addrlen) != net::sockerr)
+				{
+					return _sock;
+				};
+				_err = get_error();
+			};
+
+			close_socket(_sock);
 		};
 
-		return _sock;
+		return _err;
+	};
+
+	/**
+	 * @brief Creates a datagram socket bound to the given address
+	 * @param _address Address name, nullptr binds the wildcard address
+	 * @param _service Service name, usually port number
+	 * @return The bound socket, otherwise the error from the last address tried
+	*/
+	inline Result<socket_t> new_datagram_socket(const char* _address, const char* _service) noexcept
+	{
+		return new_datagram_socket(_address, _service, presets::none);
 	};
 
 
-	inline void set_blocking(net::socket_t _sock, bool _blocking)
+	/**
+	 * @brief Sets whether socket calls block
+	 * @return Empty result on success, otherwise the socket error
+	*/
+	inline Result<void> set_blocking(net::socket_t _sock, bool _blocking) noexcept
 	{
+#ifdef CCAP_NET_WINDOWS
 		u_long _arg = (_blocking) ? 0 : 1;
 		auto _result = ::ioctlsocket(_sock, FIONBIO, &_arg);
+#else
+		auto _result = ::fcntl(_sock, F_GETFL, 0);
+		if (_result != sockerr)
+		{
+			_result = ::fcntl(_sock, F_SETFL, (_blocking) ? (_result & ~O_NONBLOCK) : (_result | O_NONBLOCK));
+		};
+#endif
 		if (_result == net::sockerr)
 		{
-			std::terminate();
+			return get_error();
 		};
+		return {};
 	};
 
+	/**
+	 * @brief Closes a connection with a TCP reset instead of the normal shutdown, unsent data is discarded.
+		The peer sees ERR_CONNRESET at once and no TIME_WAIT state is left behind.
+	 * @return Empty result on success, otherwise the socket error
+	*/
+	inline Result<void> close_with_reset(socket_t _sock) noexcept
+	{
+		::linger _linger{};
+		_linger.l_onoff = 1;
+		_linger.l_linger = 0;
+		auto _err = ERR_NONE;
+		if (::setsockopt(_sock, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&_linger), sizeof(_linger)) == sockerr)
+		{
+			_err = get_error();
+		};
+		if (close_socket(_sock) == sockerr && _err == ERR_NONE)
+		{
+			_err = get_error();
+		};
+		return Result<void>{ _err };
+	};
 
-};
 
+
+	namespace impl
+	{
+#ifdef CCAP_NET_WINDOWS
+		/**
+		 * @brief Length type taken by the platform send and recv functions
+		*/
+		using io_length_t = int;
+#else
+		/**
+		 * @brief Length type taken by the platform send and recv functions
+		*/
+		using io_length_t = size_t;
+#endif
+
+#ifdef MSG_NOSIGNAL
+		/**
+		 * @brief Flags always passed to send, avoids SIGPIPE when the peer has gone away
+		*/
+		constexpr inline int send_flags_v = MSG_NOSIGNAL;
+#else
+		/**
+		 * @brief Flags always passed to send, avoids SIGPIPE when the peer has gone away
+		*/
+		constexpr inline int send_flags_v = 0;
+#endif
+	};
+
+	/**
+	 * @brief Accepts a pending connection from a listening socket
+	 * @return The accepted socket, ERR_WOULDBLOCK if none are pending on a non-blocking listener
+	*/
+	inline Result<socket_t> accept(socket_t _listener) noexcept
+	{
+		const socket_t _sock = ::accept(_listener, nullptr, nullptr);
+		if (_sock == nullsock) [[unlikely]]
+		{
+			return get_error();
+		};
+		return _sock;
+	};
+
+	/**
+	 * @brief Sends bytes on a connected socket
+	 * @return Number of bytes sent, ERR_WOULDBLOCK if the send buffer is full on a non-blocking socket
+	*/
+	inline Result<size_t> send(socket_t _sock, const void* _data, size_t _len, int _flags = 0) noexcept
+	{
+		const auto _result = ::send(_sock, static_cast<const char*>(_data), static_cast<impl::io_length_t>(_len), _flags | impl::send_flags_v);
+		if (_result == sockerr) [[unlikely]]
+		{
+			return get_error();
+		};
+		return static_cast<size_t>(_result);
+	};
+
+	/**
+	 * @brief Receives bytes from a connected socket
+	 * @return Number of bytes received, 0 once the peer has shut down, ERR_WOULDBLOCK if nothing is
+		available on a non-blocking socket
+	*/
+	inline Result<size_t> recv(socket_t _sock, void* _data, size_t _len, int _flags = 0) noexcept
+	{
+		const auto _result = ::recv(_sock, static_cast<char*>(_data), static_cast<impl::io_length_t>(_len), _flags);
+		if (_result == sockerr) [[unlikely]]
+		{
+			return get_error();
+		};
+		return static_cast<size_t>(_result);
+	};
+
+
+
+	/**
+	 * @brief Result of connect_fastopen
+	*/
+	struct FastOpenConnection
+	{
+		// The connected socket.
+		socket_t socket = nullsock;
+
+		// Number of bytes of the initial data sent, the caller sends the rest.
+		size_t sent = 0;
+	};
+
+	namespace impl
+	{
+		/**
+		 * @brief Connects and sends the initial data, inside the SYN when the target supports it
+		*/
+		inline Result<size_t> fastopen_connect(socket_t _sock, const ::addrinfo& _addr, const void* _data, size_t _len) noexcept
+		{
+#ifdef MSG_FASTOPEN
+			const auto _result = ::sendto(_sock, static_cast<const char*>(_data), static_cast<io_length_t>(_len),
+				MSG_FASTOPEN | send_flags_v, _addr.ai_addr, _addr.ai_addrlen);
+			if (_result != sockerr)
+			{
+				return static_cast<size_t>(_result);
+			};
+
+			// Kernels built without Fast Open reject the flag, connect normally instead
+			if (const auto _err = get_error(); _err != ERR_OPNOTSUPP)
+			{
+				return _err;
+			};
+#endif
+			if (::connect(_sock, _addr.ai_addr, _addr.ai_addrlen) == sockerr)
+			{
+				return get_error();
+			};
+			return (_len != 0) ? send(_sock, _data, _len) : Result<size_t>{ size_t{ 0 } };
+		};
+	};
+
+	/**
+	 * @brief Connects and sends the first bytes of the request in the SYN with TCP Fast Open, saving a round trip.
+
+		With a cached cookie for the server the data arrives with the SYN. Without one, or where Fast Open
+		is unavailable, the handshake completes first and the data is sent straight after, so callers never
+		need a separate path. Only send requests which are safe to replay, a SYN carrying data may be
+		delivered twice.
+
+	 * @param _address Address list
+	 * @param _data Initial request bytes
+	 * @param _opts Socket options applied before connecting
+	 * @return The socket and how much of the data was sent, otherwise the error from the last address tried
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<FastOpenConnection> connect_fastopen(const AddrList& _address, const void* _data, size_t _len, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		SocketError _err = ERR_ADDRNOTAVAIL;
+		for (auto& addr : _address)
+		{
+			const socket_t _sock = ::socket(addr.ai_family, addr.ai_socktype, addr.ai_protocol);
+			if (_sock == nullsock)
+			{
+				_err = get_error();
+				continue;
+			};
+
+			_err = set_options(_sock, _opts).error();
+			if (_err == ERR_NONE)
+			{
+				const auto _sent = impl::fastopen_connect(_sock, addr, _data, _len);
+				if (_sent)
+				{
+					return FastOpenConnection{ _sock, *_sent };
+				};
+				_err = _sent.error();
+			};
+
+			close_socket(_sock);
+		};
+		return _err;
+	};
+
+	/**
+	 * @brief Connects and sends the first bytes of the request in the SYN with TCP Fast Open, saving a round trip
+	 * @param _address Address list
+	 * @param _data Initial request bytes
+	 * @return The socket and how much of the data was sent, otherwise the error from the last address tried
+	*/
+	inline Result<FastOpenConnection> connect_fastopen(const AddrList& _address, const void* _data, size_t _len) noexcept
+	{
+		return connect_fastopen(_address, _data, _len, presets::none);
+	};
+
+	/**
+	 * @brief Connects and sends the first bytes of the request in the SYN with TCP Fast Open, saving a round trip
+	 * @param _address Address name
+	 * @param _service Service name, usually port number
+	 * @param _data Initial request bytes
+	 * @param _opts Socket options applied before connecting
+	 * @return The socket and how much of the data was sent, otherwise the resolution or connection error
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<FastOpenConnection> connect_fastopen(const char* _address, const char* _service, const void* _data, size_t _len,
+		const SocketOptions<Ts...>& _opts, ::addrinfo* _hints = nullptr) noexcept
+	{
+		const auto _addrList = (_hints) ? getaddrinfo(_address, _service, *_hints) : getaddrinfo(_address, _service);
+		if (!_addrList)
+		{
+			return _addrList.error();
+		};
+		return connect_fastopen(*_addrList, _data, _len, _opts);
+	};
+
+	/**
+	 * @brief Connects and sends the first bytes of the request in the SYN with TCP Fast Open, saving a round trip
+	 * @param _address Address name
+	 * @param _service Service name, usually port number
+	 * @param _data Initial request bytes
+	 * @return The socket and how much of the data was sent, otherwise the resolution or connection error
+	*/
+	inline Result<FastOpenConnection> connect_fastopen(const char* _address, const char* _service, const void* _data, size_t _len,
+		::addrinfo* _hints = nullptr) noexcept
+	{
+		return connect_fastopen(_address, _service, _data, _len, presets::none, _hints);
+	};
+
+#if defined(TCP_INFO) && defined(TCPI_OPT_SYN_DATA)
+	/**
+	 * @brief Checks whether a connection carried data in its SYN, Linux only
+	 * @return True if Fast Open data was sent or accepted, otherwise the socket error
+	*/
+	inline Result<bool> fastopen_used(socket_t _sock) noexcept
+	{
+		::tcp_info _info{};
+		auto _len = static_cast<::socklen_t>(sizeof(_info));
+		if (::getsockopt(_sock, IPPROTO_TCP, TCP_INFO, &_info, &_len) == sockerr)
+		{
+			return get_error();
+		};
+		return (_info.tcpi_options & TCPI_OPT_SYN_DATA) != 0;
+	};
+#endif
+
+};
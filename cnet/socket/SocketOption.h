@@ -0,0 +1,544 @@
+#pragma once
+
+/*
+	Typed socket options.
+
+	Each option is a small value type which knows its setsockopt level and name at compile time,
+	options can be bundled with make_options() or operator| and applied in a single call.
+	Options the target platform does not define are still declared so that code using them
+	compiles everywhere, applying one directly is a compile error while bundles skip them.
+*/
+
+#include <cnet/platform/Result.h>
+#include <cnet/socket/SocketType.h>
+
+#include <chrono>
+#include <tuple>
+#include <concepts>
+#include <type_traits>
+
+namespace ccap::net
+{
+	namespace impl
+	{
+		/**
+		 * @brief Option name used in place of one the target platform does not define
+		*/
+		constexpr inline int unsupported_option_v = -1;
+
+#ifdef TCP_CORK
+		constexpr inline int tcp_cork_v = TCP_CORK;
+#else
+		constexpr inline int tcp_cork_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_QUICKACK
+		constexpr inline int tcp_quickack_v = TCP_QUICKACK;
+#else
+		constexpr inline int tcp_quickack_v = unsupported_option_v;
+#endif
+
+#ifdef SO_BUSY_POLL
+		constexpr inline int so_busy_poll_v = SO_BUSY_POLL;
+#else
+		constexpr inline int so_busy_poll_v = unsupported_option_v;
+#endif
+
+#ifdef SO_PREFER_BUSY_POLL
+		constexpr inline int so_prefer_busy_poll_v = SO_PREFER_BUSY_POLL;
+#else
+		constexpr inline int so_prefer_busy_poll_v = unsupported_option_v;
+#endif
+
+#ifdef SO_BUSY_POLL_BUDGET
+		constexpr inline int so_busy_poll_budget_v = SO_BUSY_POLL_BUDGET;
+#else
+		constexpr inline int so_busy_poll_budget_v = unsupported_option_v;
+#endif
+
+#ifdef SO_INCOMING_CPU
+		constexpr inline int so_incoming_cpu_v = SO_INCOMING_CPU;
+#else
+		constexpr inline int so_incoming_cpu_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_NOTSENT_LOWAT
+		constexpr inline int tcp_notsent_lowat_v = TCP_NOTSENT_LOWAT;
+#else
+		constexpr inline int tcp_notsent_lowat_v = unsupported_option_v;
+#endif
+
+#ifdef SO_PRIORITY
+		constexpr inline int so_priority_v = SO_PRIORITY;
+#else
+		constexpr inline int so_priority_v = unsupported_option_v;
+#endif
+
+#ifdef UDP_SEGMENT
+		constexpr inline int udp_segment_v = UDP_SEGMENT;
+#else
+		constexpr inline int udp_segment_v = unsupported_option_v;
+#endif
+
+#ifdef UDP_GRO
+		constexpr inline int udp_gro_v = UDP_GRO;
+#else
+		constexpr inline int udp_gro_v = unsupported_option_v;
+#endif
+
+#ifdef SO_MAX_PACING_RATE
+		constexpr inline int so_max_pacing_rate_v = SO_MAX_PACING_RATE;
+#else
+		constexpr inline int so_max_pacing_rate_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_FASTOPEN
+		constexpr inline int tcp_fastopen_v = TCP_FASTOPEN;
+#else
+		constexpr inline int tcp_fastopen_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_FASTOPEN_CONNECT
+		constexpr inline int tcp_fastopen_connect_v = TCP_FASTOPEN_CONNECT;
+#else
+		constexpr inline int tcp_fastopen_connect_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_KEEPIDLE
+		constexpr inline int tcp_keepidle_v = TCP_KEEPIDLE;
+#else
+		constexpr inline int tcp_keepidle_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_KEEPINTVL
+		constexpr inline int tcp_keepintvl_v = TCP_KEEPINTVL;
+#else
+		constexpr inline int tcp_keepintvl_v = unsupported_option_v;
+#endif
+
+#ifdef TCP_KEEPCNT
+		constexpr inline int tcp_keepcnt_v = TCP_KEEPCNT;
+#else
+		constexpr inline int tcp_keepcnt_v = unsupported_option_v;
+#endif
+
+		/**
+		 * @brief Sets an integer socket option
+		 * @return ERR_NONE on success, otherwise the socket error
+		*/
+		inline SocketError setsockopt_int(socket_t _sock, int _level, int _name, int _value) noexcept
+		{
+			const auto _result = ::setsockopt(_sock, _level, _name, reinterpret_cast<const char*>(&_value), sizeof(_value));
+			return (_result == sockerr) ? get_error() : ERR_NONE;
+		};
+	};
+
+	/**
+	 * @brief Compile-time description of an integer valued socket option
+	 * @tparam Level Protocol level passed to setsockopt
+	 * @tparam Name Option name passed to setsockopt
+	 * @tparam T Value type exposed to the user, converted to int when applied
+	*/
+	template <int Level, int Name, typename T>
+	struct basic_socket_option
+	{
+	public:
+		using value_type = T;
+
+		constexpr static int level = Level;
+		constexpr static int name = Name;
+		constexpr static bool supported = (Name != impl::unsupported_option_v);
+
+		constexpr value_type value() const noexcept
+		{
+			return this->value_;
+		};
+
+		/**
+		 * @brief Returns the value as passed to setsockopt
+		*/
+		constexpr int native() const noexcept
+		{
+			if constexpr (requires { this->value_.count(); })
+			{
+				return static_cast<int>(this->value_.count());
+			}
+			else
+			{
+				return static_cast<int>(this->value_);
+			};
+		};
+
+		constexpr explicit basic_socket_option(value_type _value) noexcept :
+			value_{ _value }
+		{};
+
+	private:
+		value_type value_;
+	};
+
+	/**
+	 * @brief Disables Nagle's algorithm, small writes are sent immediately
+	*/
+	struct tcp_nodelay : basic_socket_option<IPPROTO_TCP, TCP_NODELAY, bool>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Holds back partial frames until uncorked, Linux only
+	*/
+	struct tcp_cork : basic_socket_option<IPPROTO_TCP, impl::tcp_cork_v, bool>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Sends ACKs immediately rather than delaying them, Linux only.
+		Not sticky, the kernel clears it again once the connection leaves quick-ack mode, so re-apply it after each read.
+	*/
+	struct tcp_quickack : basic_socket_option<IPPROTO_TCP, impl::tcp_quickack_v, bool>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Kernel send buffer size in bytes
+	*/
+	struct send_buffer : basic_socket_option<SOL_SOCKET, SO_SNDBUF, int>
+	{
+		constexpr explicit send_buffer(int _bytes) noexcept :
+			basic_socket_option{ _bytes }
+		{
+			JCLIB_ASSERT(_bytes > 0);
+		};
+	};
+
+	/**
+	 * @brief Kernel receive buffer size in bytes
+	*/
+	struct recv_buffer : basic_socket_option<SOL_SOCKET, SO_RCVBUF, int>
+	{
+		constexpr explicit recv_buffer(int _bytes) noexcept :
+			basic_socket_option{ _bytes }
+		{
+			JCLIB_ASSERT(_bytes > 0);
+		};
+	};
+
+	/**
+	 * @brief Time to busy poll the device queue on blocking reads, Linux only
+	*/
+	struct busy_poll : basic_socket_option<SOL_SOCKET, impl::so_busy_poll_v, std::chrono::microseconds>
+	{
+		constexpr explicit busy_poll(std::chrono::microseconds _duration) noexcept :
+			basic_socket_option{ _duration }
+		{
+			JCLIB_ASSERT(_duration.count() >= 0);
+		};
+	};
+
+	/**
+	 * @brief Prefers busy polling over interrupt driven receive while the application keeps polling, Linux 5.11+
+	*/
+	struct prefer_busy_poll : basic_socket_option<SOL_SOCKET, impl::so_prefer_busy_poll_v, bool>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Maximum packets processed per busy poll iteration, raising it needs CAP_NET_ADMIN, Linux 5.11+
+	*/
+	struct busy_poll_budget : basic_socket_option<SOL_SOCKET, impl::so_busy_poll_budget_v, int>
+	{
+		constexpr explicit busy_poll_budget(int _packets) noexcept :
+			basic_socket_option{ _packets }
+		{
+			JCLIB_ASSERT(_packets > 0);
+		};
+	};
+
+	/**
+	 * @brief CPU whose softirq handles the socket's packets, read it with get_option<incoming_cpu>.
+		Setting it on SO_REUSEPORT listeners steers new connections to the listener on that CPU, Linux only
+	*/
+	struct incoming_cpu : basic_socket_option<SOL_SOCKET, impl::so_incoming_cpu_v, int>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Limits unsent bytes queued in the kernel, keeps latency of the next write low, Linux only
+	*/
+	struct tcp_notsent_lowat : basic_socket_option<IPPROTO_TCP, impl::tcp_notsent_lowat_v, int>
+	{
+		constexpr explicit tcp_notsent_lowat(int _bytes) noexcept :
+			basic_socket_option{ _bytes }
+		{
+			JCLIB_ASSERT(_bytes > 0);
+		};
+	};
+
+	/**
+	 * @brief Queueing priority for outgoing packets, 0-6 without CAP_NET_ADMIN, Linux only
+	*/
+	struct priority : basic_socket_option<SOL_SOCKET, impl::so_priority_v, int>
+	{
+		constexpr explicit priority(int _priority) noexcept :
+			basic_socket_option{ _priority }
+		{
+			JCLIB_ASSERT(_priority >= 0);
+		};
+	};
+
+	/**
+	 * @brief Default GSO segment size for UDP sends, the kernel splits larger sends into datagrams of this size, Linux only
+	*/
+	struct udp_segment : basic_socket_option<IPPROTO_UDP, impl::udp_segment_v, int>
+	{
+		constexpr explicit udp_segment(int _bytes) noexcept :
+			basic_socket_option{ _bytes }
+		{
+			JCLIB_ASSERT(_bytes >= 0 && _bytes <= 0xFFFF);
+		};
+	};
+
+	/**
+	 * @brief Lets the kernel coalesce received UDP datagrams into one buffer, see recv_gro, Linux only
+	*/
+	struct udp_gro : basic_socket_option<IPPROTO_UDP, impl::udp_gro_v, bool>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Caps the rate the kernel sends at, in bytes per second, enforced by TCP's internal pacing
+		or the fq qdisc, Linux only. UINT32_MAX removes the cap
+	*/
+	struct max_pacing_rate : basic_socket_option<SOL_SOCKET, impl::so_max_pacing_rate_v, uint32_t>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief Enables TCP Fast Open on a listener, accepting data carried in the SYN.
+		Set it before listening, Linux also needs bit 2 of the net.ipv4.tcp_fastopen sysctl
+	*/
+	struct tcp_fastopen : basic_socket_option<IPPROTO_TCP, impl::tcp_fastopen_v, int>
+	{
+		/**
+		 * @param _queueLength Maximum number of Fast Open requests waiting for accept
+		*/
+		constexpr explicit tcp_fastopen(int _queueLength) noexcept :
+			basic_socket_option{ _queueLength }
+		{
+			JCLIB_ASSERT(_queueLength >= 0);
+		};
+	};
+
+	/**
+	 * @brief Makes connect() defer the SYN until the first write so the data can ride on it, Linux only
+	*/
+	struct tcp_fastopen_connect : basic_socket_option<IPPROTO_TCP, impl::tcp_fastopen_connect_v, bool>
+	{
+		using basic_socket_option::basic_socket_option;
+	};
+
+	/**
+	 * @brief TCP keepalive, zero durations and counts leave the system default in place
+	*/
+	struct keepalive
+	{
+	public:
+		constexpr static bool supported = true;
+
+		bool enabled = true;
+		std::chrono::seconds idle{ 0 };
+		std::chrono::seconds interval{ 0 };
+		int count = 0;
+	};
+
+	/**
+	 * @brief Satisfied by types which can be passed to set_option
+	*/
+	template <typename T>
+	concept cx_socket_option = requires { { T::supported } -> std::convertible_to<bool>; };
+
+
+
+	/**
+	 * @brief Applies an integer valued socket option
+	 * @param _sock Socket to modify
+	 * @param _opt Option to apply
+	 * @return Empty result on success, otherwise the socket error
+	*/
+	template <int Level, int Name, typename T>
+	inline Result<void> set_option(socket_t _sock, const basic_socket_option<Level, Name, T>& _opt) noexcept
+	{
+		static_assert(basic_socket_option<Level, Name, T>::supported, "socket option is not supported on the target platform");
+		return impl::setsockopt_int(_sock, Level, Name, _opt.native());
+	};
+
+	/**
+	 * @brief Applies TCP keepalive settings
+	 * @param _sock Socket to modify
+	 * @param _opt Keepalive settings
+	 * @return Empty result on success, otherwise the socket error
+	*/
+	inline Result<void> set_option(socket_t _sock, const keepalive& _opt) noexcept
+	{
+		auto _err = impl::setsockopt_int(_sock, SOL_SOCKET, SO_KEEPALIVE, _opt.enabled);
+		if (_err != ERR_NONE || !_opt.enabled)
+		{
+			return Result<void>{ _err };
+		};
+
+		const auto _setIf = [_sock, &_err](int _name, int _value)
+		{
+			if (_err == ERR_NONE && _value > 0 && _name != impl::unsupported_option_v)
+			{
+				_err = impl::setsockopt_int(_sock, IPPROTO_TCP, _name, _value);
+			};
+		};
+		_setIf(impl::tcp_keepidle_v, static_cast<int>(_opt.idle.count()));
+		_setIf(impl::tcp_keepintvl_v, static_cast<int>(_opt.interval.count()));
+		_setIf(impl::tcp_keepcnt_v, _opt.count);
+		return Result<void>{ _err };
+	};
+
+	/**
+	 * @brief Reads back the current value of an integer valued socket option
+	 * @param _sock Socket to query
+	 * @return The native option value on success, otherwise the socket error
+	*/
+	template <typename OptionT>
+	requires (OptionT::supported && requires { OptionT::level; OptionT::name; })
+	inline Result<int> get_option(socket_t _sock) noexcept
+	{
+		int _value{};
+		auto _len = static_cast<::socklen_t>(sizeof(_value));
+		const auto _result = ::getsockopt(_sock, OptionT::level, OptionT::name, reinterpret_cast<char*>(&_value), &_len);
+		if (_result == sockerr)
+		{
+			return get_error();
+		};
+		return _value;
+	};
+
+
+
+	/**
+	 * @brief A set of socket options applied together, built with make_options() or operator|
+	*/
+	template <cx_socket_option... Ts>
+	struct SocketOptions
+	{
+	public:
+		using tuple_type = std::tuple<Ts...>;
+
+		constexpr static size_t size() noexcept
+		{
+			return sizeof...(Ts);
+		};
+
+		constexpr const tuple_type& options() const noexcept
+		{
+			return this->options_;
+		};
+
+		/**
+		 * @brief Returns a new set with an additional option appended
+		*/
+		template <cx_socket_option U>
+		constexpr SocketOptions<Ts..., U> operator|(const U& _opt) const
+		{
+			return std::apply([&_opt](const auto&... _opts)
+			{
+				return SocketOptions<Ts..., U>{ _opts..., _opt };
+			}, this->options_);
+		};
+
+		constexpr SocketOptions() = default;
+		constexpr explicit SocketOptions(const Ts&... _opts) requires (sizeof...(Ts) != 0) :
+			options_{ _opts... }
+		{};
+
+	private:
+		tuple_type options_;
+	};
+
+	/**
+	 * @brief Bundles several socket options into a SocketOptions set
+	*/
+	template <cx_socket_option... Ts>
+	constexpr inline SocketOptions<Ts...> make_options(const Ts&... _opts)
+	{
+		return SocketOptions<Ts...>{ _opts... };
+	};
+
+	/**
+	 * @brief Applies a set of socket options, options unsupported on the target platform are skipped
+	 * @param _sock Socket to modify
+	 * @param _opts Options to apply
+	 * @return Empty result on success, otherwise the error from the first option that failed
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<void> set_options(socket_t _sock, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		auto _err = ERR_NONE;
+		const auto _apply = [_sock, &_err]<typename T>(const T& _opt)
+		{
+			if constexpr (T::supported)
+			{
+				_err = set_option(_sock, _opt).error();
+			};
+			return _err == ERR_NONE;
+		};
+		std::apply([&_apply](const auto&... _opt) { static_cast<void>((_apply(_opt) && ...)); }, _opts.options());
+		return Result<void>{ _err };
+	};
+
+	/**
+	 * @brief Applies several socket options, options unsupported on the target platform are skipped
+	 * @return Empty result on success, otherwise the error from the first option that failed
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<void> set_options(socket_t _sock, const Ts&... _opts) noexcept
+	{
+		return set_options(_sock, make_options(_opts...));
+	};
+
+
+
+	/**
+	 * @brief Named option sets for common workloads
+	*/
+	namespace presets
+	{
+		/**
+		 * @brief Nothing applied, the default for connect and new_listener
+		*/
+		constexpr inline SocketOptions<> none{};
+
+		/**
+		 * @brief Small request/response traffic where every microsecond counts
+		*/
+		constexpr inline auto low_latency = make_options
+		(
+			tcp_nodelay{ true },
+			tcp_notsent_lowat{ 16 * 1024 },
+			priority{ 6 }
+		);
+
+		/**
+		 * @brief Large transfers where throughput matters more than latency
+		*/
+		constexpr inline auto bulk_throughput = make_options
+		(
+			tcp_nodelay{ false },
+			send_buffer{ 4 * 1024 * 1024 },
+			recv_buffer{ 4 * 1024 * 1024 }
+		);
+	};
+
+};
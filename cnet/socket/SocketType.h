@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cnet/platform/SocketLib.h>
+
+namespace ccap::net
+{
+#ifdef CCAP_NET_WINDOWS
+	/**
+	 * @brief Platform socket type alias
+	*/
+	using socket_t = ::SOCKET;
+#else
+	/**
+	 * @brief Platform socket type alias
+	*/
+	using socket_t = int;
+#endif
+
+#ifdef CCAP_NET_WINDOWS
+	/**
+	 * @brief Platform-independent null socket value
+	*/
+	constexpr inline socket_t nullsock = INVALID_SOCKET;
+	constexpr inline int sockerr = SOCKET_ERROR;
+#else
+	/**
+	 * @brief Platform-independent null socket value
+	*/
+	constexpr inline socket_t nullsock = -1;
+	constexpr inline int sockerr = -1;
+#endif
+
+	/**
+	 * @brief Closes a socket handle using the platform's close function
+	 * @param _sock Socket to close
+	 * @return 0 on success, sockerr on failure
+	*/
+	inline int close_socket(socket_t _sock) noexcept
+	{
+#ifdef CCAP_NET_WINDOWS
+		return ::closesocket(_sock);
+#else
+		return ::close(_sock);
+#endif
+	};
+
+};
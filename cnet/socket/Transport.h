@@ -0,0 +1,105 @@
+#pragma once
+
+/*
+	Minimal transport interface shared by the real sockets and the simulated network in cnet/sim, so
+	protocol and framing code written against cx_transport runs unchanged on either. Every socket a
+	transport hands out is non-blocking.
+*/
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+
+#include <span>
+#include <chrono>
+#include <concepts>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Satisfied by types providing the stream socket surface of Socket.h as member functions
+	*/
+	template <typename T>
+	concept cx_transport = requires(T& _transport, socket_t _sock, const char* _str, void* _data, const void* _cdata,
+		size_t _len, std::span<::pollfd> _fds, std::chrono::milliseconds _timeout)
+	{
+		{ _transport.connect(_str, _str) } -> std::same_as<Result<socket_t>>;
+		{ _transport.new_listener(_str, _str, int{}) } -> std::same_as<Result<socket_t>>;
+		{ _transport.accept(_sock) } -> std::same_as<Result<socket_t>>;
+		{ _transport.send(_sock, _cdata, _len) } -> std::same_as<Result<size_t>>;
+		{ _transport.recv(_sock, _data, _len) } -> std::same_as<Result<size_t>>;
+		{ _transport.close(_sock) } -> std::same_as<Result<void>>;
+		{ _transport.poll(_fds, _timeout) } -> std::same_as<Result<int>>;
+	};
+
+	/**
+	 * @brief Transport backed by the platform's sockets
+	*/
+	struct SystemTransport
+	{
+	public:
+		Result<socket_t> connect(const char* _address, const char* _service) noexcept
+		{
+			return make_nonblocking(net::connect(_address, _service));
+		};
+		Result<socket_t> new_listener(const char* _address, const char* _service, int _backlog) noexcept
+		{
+			return make_nonblocking(net::new_listener(_address, _service, _backlog));
+		};
+		Result<socket_t> accept(socket_t _listener) noexcept
+		{
+			return make_nonblocking(net::accept(_listener));
+		};
+
+		Result<size_t> send(socket_t _sock, const void* _data, size_t _len) noexcept
+		{
+			return net::send(_sock, _data, _len);
+		};
+		Result<size_t> recv(socket_t _sock, void* _data, size_t _len) noexcept
+		{
+			return net::recv(_sock, _data, _len);
+		};
+
+		Result<void> close(socket_t _sock) noexcept
+		{
+			if (close_socket(_sock) == sockerr)
+			{
+				return get_error();
+			};
+			return {};
+		};
+
+		/**
+		 * @brief Waits for readiness on the given sockets
+		 * @return Number of ready sockets, 0 on timeout, otherwise the socket error
+		*/
+		Result<int> poll(std::span<::pollfd> _fds, std::chrono::milliseconds _timeout) noexcept
+		{
+#ifdef CCAP_NET_WINDOWS
+			const auto _result = ::WSAPoll(_fds.data(), static_cast<ULONG>(_fds.size()), static_cast<int>(_timeout.count()));
+#else
+			const auto _result = ::poll(_fds.data(), static_cast<::nfds_t>(_fds.size()), static_cast<int>(_timeout.count()));
+#endif
+			if (_result == sockerr)
+			{
+				return get_error();
+			};
+			return _result;
+		};
+
+	private:
+		static Result<socket_t> make_nonblocking(Result<socket_t> _sock) noexcept
+		{
+			if (_sock)
+			{
+				if (const auto _set = set_blocking(*_sock, false); !_set)
+				{
+					close_socket(*_sock);
+					return _set.error();
+				};
+			};
+			return _sock;
+		};
+	};
+
+};
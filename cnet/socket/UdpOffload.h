@@ -0,0 +1,149 @@
+#pragma once
+
+/*
+	UDP segmentation offload.
+
+	send_gso() hands the kernel one large buffer which it splits into datagrams of a fixed segment size,
+	recv_gro() receives several coalesced datagrams in one call along with their segment size. Either way
+	a single syscall and stack traversal covers many packets. Only available on Linux 4.18+ (GSO) and
+	5.0+ (GRO), enable receive coalescing with the udp_gro socket option.
+*/
+
+#include <cnet/socket/Socket.h>
+
+#if defined(CCAP_NET_UNIX) && defined(UDP_SEGMENT)
+
+#include <cstdint>
+#include <cstring>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Maximum datagrams the kernel will build from one GSO send
+	*/
+	constexpr inline size_t udp_max_segments_v = 64;
+
+	/**
+	 * @brief Sends a buffer as a train of datagrams of the given size, the last may be shorter
+	 * @param _sock UDP socket, connected unless a destination is given
+	 * @param _data Payload, at most udp_max_segments_v segments long
+	 * @param _segmentSize Size of each datagram's payload
+	 * @param _to Destination address, nullptr for a connected socket
+	 * @param _toLen Size of the destination address
+	 * @return Number of payload bytes sent, otherwise the socket error
+	*/
+	inline Result<size_t> send_gso(socket_t _sock, const void* _data, size_t _len, uint16_t _segmentSize,
+		const ::sockaddr* _to = nullptr, ::socklen_t _toLen = 0) noexcept
+	{
+		if (_segmentSize == 0 || _len > _segmentSize * udp_max_segments_v)
+		{
+			return ERR_MSGSIZE;
+		};
+
+		alignas(::cmsghdr) char _control[CMSG_SPACE(sizeof(uint16_t))]{};
+
+		::iovec _iov{};
+		_iov.iov_base = const_cast<void*>(_data);
+		_iov.iov_len = _len;
+
+		::msghdr _msg{};
+		_msg.msg_name = const_cast<::sockaddr*>(_to);
+		_msg.msg_namelen = _toLen;
+		_msg.msg_iov = &_iov;
+		_msg.msg_iovlen = 1;
+		_msg.msg_control = _control;
+		_msg.msg_controllen = sizeof(_control);
+
+		auto _cmsg = CMSG_FIRSTHDR(&_msg);
+		_cmsg->cmsg_level = IPPROTO_UDP;
+		_cmsg->cmsg_type = UDP_SEGMENT;
+		_cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		std::memcpy(CMSG_DATA(_cmsg), &_segmentSize, sizeof(_segmentSize));
+
+		const auto _result = ::sendmsg(_sock, &_msg, impl::send_flags_v);
+		if (_result == sockerr) [[unlikely]]
+		{
+			return get_error();
+		};
+		return static_cast<size_t>(_result);
+	};
+
+	/**
+	 * @brief Result of a recv_gro call
+	*/
+	struct GroReceived
+	{
+		// Total payload bytes received across all coalesced datagrams.
+		size_t bytes = 0;
+
+		// Size of each datagram, the last may be shorter. Equal to bytes if nothing was coalesced.
+		size_t segment_size = 0;
+
+		// Set if the train did not fit in the buffer. The rest was discarded by the kernel, bytes only counts
+		// what was copied and the last segment counted may be cut short.
+		bool truncated = false;
+
+		/**
+		 * @brief Number of datagrams held in the buffer
+		*/
+		size_t segments() const noexcept
+		{
+			return (this->segment_size == 0) ? 0 : (this->bytes + this->segment_size - 1) / this->segment_size;
+		};
+	};
+
+	/**
+	 * @brief Receives one datagram or a coalesced train of them from a socket with udp_gro enabled
+	 * @param _data Buffer, should be at least 64KiB to take a full train
+	 * @param _from Set to the sender's address if not nullptr
+	 * @param _fromLen In/out size of the sender's address
+	 * @return Bytes received and the segment size, check truncated before trusting the last segment, otherwise the socket error
+	*/
+	inline Result<GroReceived> recv_gro(socket_t _sock, void* _data, size_t _len,
+		::sockaddr* _from = nullptr, ::socklen_t* _fromLen = nullptr) noexcept
+	{
+		alignas(::cmsghdr) char _control[CMSG_SPACE(sizeof(int))]{};
+
+		::iovec _iov{};
+		_iov.iov_base = _data;
+		_iov.iov_len = _len;
+
+		::msghdr _msg{};
+		_msg.msg_name = _from;
+		_msg.msg_namelen = (_fromLen) ? *_fromLen : 0;
+		_msg.msg_iov = &_iov;
+		_msg.msg_iovlen = 1;
+		_msg.msg_control = _control;
+		_msg.msg_controllen = sizeof(_control);
+
+		const auto _result = ::recvmsg(_sock, &_msg, 0);
+		if (_result == sockerr) [[unlikely]]
+		{
+			return get_error();
+		};
+		if (_fromLen)
+		{
+			*_fromLen = _msg.msg_namelen;
+		};
+
+		GroReceived _out{};
+		_out.bytes = static_cast<size_t>(_result);
+		_out.segment_size = _out.bytes;
+		_out.truncated = (_msg.msg_flags & MSG_TRUNC) != 0;
+
+		for (auto _cmsg = CMSG_FIRSTHDR(&_msg); _cmsg; _cmsg = CMSG_NXTHDR(&_msg, _cmsg))
+		{
+			if (_cmsg->cmsg_level == IPPROTO_UDP && _cmsg->cmsg_type == UDP_GRO)
+			{
+				int _segment{};
+				std::memcpy(&_segment, CMSG_DATA(_cmsg), sizeof(_segment));
+				_out.segment_size = static_cast<size_t>(_segment);
+				break;
+			};
+		};
+		return _out;
+	};
+
+};
+
+#endif
@@ -0,0 +1,323 @@
+#pragma once
+
+/*
+	Unix domain sockets for same-host IPC, plus passing descriptors between processes with SCM_RIGHTS.
+	Only available when CCAP_NET_UNIX is defined.
+*/
+
+#include <cnet/platform/Platform.h>
+#include <cnet/platform/Result.h>
+#include <cnet/socket/Socket.h>
+
+#ifdef CCAP_NET_UNIX
+
+#include <span>
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace ccap::net
+{
+	/**
+	 * @brief Unix domain socket types
+	*/
+	enum class UnixSocketType : int
+	{
+		// Reliable byte stream, like TCP.
+		stream = SOCK_STREAM,
+
+		// Reliable connection with message boundaries preserved.
+		seqpacket = SOCK_SEQPACKET
+	};
+
+	/**
+	 * @brief Address of a Unix domain socket, either a filesystem path or a Linux abstract namespace name
+	*/
+	struct UnixAddress
+	{
+	public:
+		const ::sockaddr* get() const noexcept
+		{
+			return reinterpret_cast<const ::sockaddr*>(&this->addr_);
+		};
+		::socklen_t length() const noexcept
+		{
+			return this->len_;
+		};
+
+		/**
+		 * @brief True if the address is in the abstract namespace rather than the filesystem
+		*/
+		bool is_abstract() const noexcept
+		{
+			return this->len_ > offsetof(::sockaddr_un, sun_path) && this->addr_.sun_path[0] == '\0';
+		};
+
+		/**
+		 * @brief Creates an address for a filesystem path
+		 * @return The address, ERR_NAMETOOLONG if the path does not fit
+		*/
+		static Result<UnixAddress> path(std::string_view _path) noexcept
+		{
+			UnixAddress _out{};
+			if (_path.empty() || _path.size() >= sizeof(_out.addr_.sun_path))
+			{
+				return (_path.empty()) ? ERR_INVAL : ERR_NAMETOOLONG;
+			};
+			std::memcpy(_out.addr_.sun_path, _path.data(), _path.size());
+			_out.len_ = static_cast<::socklen_t>(offsetof(::sockaddr_un, sun_path) + _path.size() + 1);
+			return _out;
+		};
+
+#ifdef __linux__
+		/**
+		 * @brief Creates an address in the Linux abstract namespace, these never touch the filesystem
+			and vanish once the last socket bound to them closes
+		 * @param _name Name without the leading null byte
+		 * @return The address, ERR_NAMETOOLONG if the name does not fit
+		*/
+		static Result<UnixAddress> abstract(std::string_view _name) noexcept
+		{
+			UnixAddress _out{};
+			if (_name.size() >= sizeof(_out.addr_.sun_path))
+			{
+				return ERR_NAMETOOLONG;
+			};
+			std::memcpy(_out.addr_.sun_path + 1, _name.data(), _name.size());
+			_out.len_ = static_cast<::socklen_t>(offsetof(::sockaddr_un, sun_path) + 1 + _name.size());
+			return _out;
+		};
+#endif
+
+		UnixAddress() noexcept
+		{
+			this->addr_.sun_family = AF_UNIX;
+		};
+
+	private:
+		::sockaddr_un addr_{};
+		::socklen_t len_ = 0;
+	};
+
+
+
+	/**
+	 * @brief Connects to a Unix domain socket
+	 * @param _address Address to connect to
+	 * @param _type Socket type, must match the listener
+	 * @param _opts Socket options applied before connecting
+	 * @return The connected socket, otherwise the socket error
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> connect(const UnixAddress& _address, UnixSocketType _type, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		const socket_t _sock = ::socket(AF_UNIX, static_cast<int>(_type), 0);
+		if (_sock == nullsock)
+		{
+			return get_error();
+		};
+
+		auto _err = set_options(_sock, _opts).error();
+		if (_err == ERR_NONE)
+		{
+			if (::connect(_sock, _address.get(), _address.length()) != sockerr)
+			{
+				return _sock;
+			};
+			_err = get_error();
+		};
+
+		close_socket(_sock);
+		return _err;
+	};
+
+	/**
+	 * @brief Connects to a Unix domain socket
+	 * @param _address Address to connect to
+	 * @param _type Socket type, must match the listener
+	 * @return The connected socket, otherwise the socket error
+	*/
+	inline Result<socket_t> connect(const UnixAddress& _address, UnixSocketType _type = UnixSocketType::stream) noexcept
+	{
+		return connect(_address, _type, presets::none);
+	};
+
+	/**
+	 * @brief Creates a Unix domain socket bound to the given address and starts listening on it.
+		Binding to a filesystem path fails with ERR_ADDRINUSE if the path already exists.
+	 * @param _address Address to bind to
+	 * @param _backlog Maximum length of the pending connection queue
+	 * @param _type Socket type
+	 * @param _opts Socket options applied before listening
+	 * @return The listening socket, otherwise the socket error
+	*/
+	template <cx_socket_option... Ts>
+	inline Result<socket_t> new_listener(const UnixAddress& _address, int _backlog, UnixSocketType _type, const SocketOptions<Ts...>& _opts) noexcept
+	{
+		const socket_t _sock = ::socket(AF_UNIX, static_cast<int>(_type), 0);
+		if (_sock == nullsock)
+		{
+			return get_error();
+		};
+
+		auto _err = set_options(_sock, _opts).error();
+		if (_err == ERR_NONE)
+		{
+			if (::bind(_sock, _address.get(), _address.length()) != sockerr &&
+				::listen(_sock, _backlog) != sockerr)
+			{
+				return _sock;
+			};
+			_err = get_error();
+		};
+
+		close_socket(_sock);
+		return _err;
+	};
+
+	/**
+	 * @brief Creates a Unix domain socket bound to the given address and starts listening on it.
+		Binding to a filesystem path fails with ERR_ADDRINUSE if the path already exists.
+	 * @param _address Address to bind to
+	 * @param _backlog Maximum length of the pending connection queue
+	 * @param _type Socket type
+	 * @return The listening socket, otherwise the socket error
+	*/
+	inline Result<socket_t> new_listener(const UnixAddress& _address, int _backlog, UnixSocketType _type = UnixSocketType::stream) noexcept
+	{
+		return new_listener(_address, _backlog, _type, presets::none);
+	};
+
+
+
+	/**
+	 * @brief Maximum number of descriptors passed in a single message, matches the Linux SCM_MAX_FD limit
+	*/
+	constexpr inline size_t max_passed_fds_v = 253;
+
+	/**
+	 * @brief Sends bytes along with a set of descriptors over a Unix domain socket.
+		The receiver gets duplicates of the descriptors, the caller's copies stay open.
+	 * @param _data Bytes to send, at least one byte is required to carry the descriptors
+	 * @param _fds Descriptors to pass, at most max_passed_fds_v
+	 * @return Number of bytes sent, otherwise the socket error
+	*/
+	inline Result<size_t> send_fds(socket_t _sock, const void* _data, size_t _len, std::span<const socket_t> _fds) noexcept
+	{
+		if (_len == 0 || _fds.size() > max_passed_fds_v)
+		{
+			return ERR_INVAL;
+		};
+
+		alignas(::cmsghdr) char _control[CMSG_SPACE(sizeof(socket_t) * max_passed_fds_v)];
+
+		::iovec _iov{};
+		_iov.iov_base = const_cast<void*>(_data);
+		_iov.iov_len = _len;
+
+		::msghdr _msg{};
+		_msg.msg_iov = &_iov;
+		_msg.msg_iovlen = 1;
+
+		if (!_fds.empty())
+		{
+			const auto _bytes = sizeof(socket_t) * _fds.size();
+			_msg.msg_control = _control;
+			_msg.msg_controllen = CMSG_SPACE(_bytes);
+
+			auto _cmsg = CMSG_FIRSTHDR(&_msg);
+			_cmsg->cmsg_level = SOL_SOCKET;
+			_cmsg->cmsg_type = SCM_RIGHTS;
+			_cmsg->cmsg_len = CMSG_LEN(_bytes);
+			std::memcpy(CMSG_DATA(_cmsg), _fds.data(), _bytes);
+		};
+
+		const auto _result = ::sendmsg(_sock, &_msg, impl::send_flags_v);
+		if (_result == sockerr)
+		{
+			return get_error();
+		};
+		return static_cast<size_t>(_result);
+	};
+
+	/**
+	 * @brief Result of a recv_fds call
+	*/
+	struct ReceivedFds
+	{
+		// Number of data bytes received, 0 once the peer has shut down.
+		size_t bytes = 0;
+
+		// Number of descriptors written to the output span.
+		size_t count = 0;
+
+		// Set if more descriptors were sent than fit, the kernel closes the extras.
+		bool truncated = false;
+	};
+
+	/**
+	 * @brief Receives bytes and any descriptors passed alongside them.
+		Received descriptors are new descriptors owned by the caller and have close-on-exec set.
+	 * @param _data Buffer for the received bytes
+	 * @param _fds Output span for the received descriptors
+	 * @return Bytes and descriptor count received, otherwise the socket error
+	*/
+	inline Result<ReceivedFds> recv_fds(socket_t _sock, void* _data, size_t _len, std::span<socket_t> _fds) noexcept
+	{
+		alignas(::cmsghdr) char _control[CMSG_SPACE(sizeof(socket_t) * max_passed_fds_v)];
+
+		::iovec _iov{};
+		_iov.iov_base = _data;
+		_iov.iov_len = _len;
+
+		::msghdr _msg{};
+		_msg.msg_iov = &_iov;
+		_msg.msg_iovlen = 1;
+		_msg.msg_control = _control;
+		_msg.msg_controllen = CMSG_SPACE(sizeof(socket_t) * std::min(_fds.size(), max_passed_fds_v));
+
+#ifdef MSG_CMSG_CLOEXEC
+		constexpr int _flags = MSG_CMSG_CLOEXEC;
+#else
+		constexpr int _flags = 0;
+#endif
+		const auto _result = ::recvmsg(_sock, &_msg, _flags);
+		if (_result == sockerr)
+		{
+			return get_error();
+		};
+
+		ReceivedFds _out{};
+		_out.bytes = static_cast<size_t>(_result);
+		_out.truncated = (_msg.msg_flags & MSG_CTRUNC) != 0;
+
+		for (auto _cmsg = CMSG_FIRSTHDR(&_msg); _cmsg; _cmsg = CMSG_NXTHDR(&_msg, _cmsg))
+		{
+			if (_cmsg->cmsg_level != SOL_SOCKET || _cmsg->cmsg_type != SCM_RIGHTS)
+			{
+				continue;
+			};
+
+			const auto _count = (_cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(socket_t);
+			const auto _space = _fds.size() - _out.count;
+			const auto _copied = std::min(_count, _space);
+			std::memcpy(_fds.data() + _out.count, CMSG_DATA(_cmsg), _copied * sizeof(socket_t));
+			_out.count += _copied;
+
+			// Anything beyond the output span would otherwise leak
+			for (size_t n = _copied; n != _count; ++n)
+			{
+				socket_t _extra{};
+				std::memcpy(&_extra, CMSG_DATA(_cmsg) + n * sizeof(socket_t), sizeof(socket_t));
+				close_socket(_extra);
+				_out.truncated = true;
+			};
+		};
+
+		return _out;
+	};
+
+};
+
+#endif
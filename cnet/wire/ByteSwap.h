@@ -0,0 +1,139 @@
+#pragma once
+
+/*
+	Endian conversion between host and network byte order.
+
+	Uses std::byteswap where the standard library provides it. Arrays are swapped 16 bytes at a time
+	with SSSE3 shuffles when available, otherwise with a plain loop the compiler can vectorize.
+*/
+
+#include <bit>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <concepts>
+#include <type_traits>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace ccap::net
+{
+	/**
+	 * @brief Reverses the bytes of an integer
+	*/
+	template <std::integral T>
+	constexpr inline T byteswap(T _value) noexcept
+	{
+#if defined(__cpp_lib_byteswap)
+		return std::byteswap(_value);
+#else
+		if constexpr (sizeof(T) == 1)
+		{
+			return _value;
+		}
+		else
+		{
+			using U = std::make_unsigned_t<T>;
+			auto _in = static_cast<U>(_value);
+			U _out{};
+			for (size_t n = 0; n != sizeof(T); ++n)
+			{
+				_out = static_cast<U>((_out << 8) | (_in & 0xFF));
+				_in = static_cast<U>(_in >> 8);
+			};
+			return static_cast<T>(_out);
+		};
+#endif
+	};
+
+	/**
+	 * @brief Converts an integer between host and network (big endian) byte order, the conversion is its own inverse
+	*/
+	template <std::integral T>
+	constexpr inline T to_network(T _value) noexcept
+	{
+		static_assert(std::endian::native == std::endian::little || std::endian::native == std::endian::big,
+			"mixed endian targets are not supported");
+
+		if constexpr (std::endian::native == std::endian::big)
+		{
+			return _value;
+		}
+		else
+		{
+			return byteswap(_value);
+		};
+	};
+
+	/**
+	 * @brief Converts an integer between network (big endian) and host byte order
+	*/
+	template <std::integral T>
+	constexpr inline T from_network(T _value) noexcept
+	{
+		return to_network(_value);
+	};
+
+	namespace impl
+	{
+#if defined(__SSSE3__)
+		/**
+		 * @brief Shuffle mask which reverses each Size byte lane of a 16 byte vector
+		*/
+		template <size_t Size>
+		inline __m128i byteswap_mask() noexcept
+		{
+			alignas(16) uint8_t _mask[16]{};
+			for (size_t n = 0; n != 16; ++n)
+			{
+				_mask[n] = static_cast<uint8_t>((n / Size) * Size + (Size - 1 - n % Size));
+			};
+			return _mm_load_si128(reinterpret_cast<const __m128i*>(_mask));
+		};
+#endif
+	};
+
+	/**
+	 * @brief Copies an array of integers converting each between host and network byte order.
+		The source and destination may be unaligned and may be the same buffer.
+	 * @tparam T Element type
+	 * @param _dest Destination bytes, at least _count * sizeof(T) long
+	 * @param _src Source bytes, at least _count * sizeof(T) long
+	 * @param _count Number of elements
+	*/
+	template <std::integral T>
+	inline void copy_to_network(std::byte* _dest, const std::byte* _src, size_t _count) noexcept
+	{
+		size_t n = 0;
+		if constexpr (sizeof(T) == 1 || std::endian::native == std::endian::big)
+		{
+			std::memmove(_dest, _src, _count * sizeof(T));
+			return;
+		}
+#if defined(__SSSE3__)
+		else
+		{
+			constexpr size_t _perVector = 16 / sizeof(T);
+			const auto _mask = impl::byteswap_mask<sizeof(T)>();
+			for (; n + _perVector <= _count; n += _perVector)
+			{
+				const auto _offset = n * sizeof(T);
+				const auto _v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + _offset));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dest + _offset), _mm_shuffle_epi8(_v, _mask));
+			};
+		};
+#endif
+
+		for (; n != _count; ++n)
+		{
+			T _value{};
+			std::memcpy(&_value, _src + n * sizeof(T), sizeof(T));
+			_value = to_network(_value);
+			std::memcpy(_dest + n * sizeof(T), &_value, sizeof(T));
+		};
+	};
+
+};
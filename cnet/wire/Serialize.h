@@ -0,0 +1,397 @@
+#pragma once
+
+/*
+	Compile-time reflected wire format for plain message structs.
+
+	Any aggregate whose fields are integers, enums, bools, floats, std::arrays of those or nested
+	aggregates of those can be encoded. Fields are written in declaration order, big endian, with no
+	padding, so the wire layout is fully determined by the struct and checked at compile time. Use
+	std::array rather than C arrays for array fields, brace elision hides C arrays from reflection.
+
+		struct Header
+		{
+			uint16_t type;
+			uint32_t length;
+			std::array<uint32_t, 4> ids;
+		};
+		static_assert(wire_size_v<Header> == 22);
+
+		auto _bytes = encode(Header{ 1, 2, { 3, 4, 5, 6 } });
+		net::send(_sock, _bytes.data(), _bytes.size());
+
+		// Or encode straight into a stack buffer and send it in one step
+		net::send_message(_sock, Header{ 1, 2, { 3, 4, 5, 6 } });
+*/
+
+#include <cnet/wire/ByteSwap.h>
+#include <cnet/socket/Socket.h>
+
+#include <span>
+#include <array>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+
+namespace ccap::net
+{
+	namespace impl
+	{
+		/**
+		 * @brief Converts to any field type, used to count an aggregate's fields
+		*/
+		struct any_field
+		{
+			template <typename T>
+			constexpr operator T() const noexcept;
+		};
+
+		template <typename T, size_t... Is>
+		constexpr inline bool aggregate_takes_v = requires { T{ (static_cast<void>(Is), any_field{})... }; };
+
+		template <typename T, size_t N>
+		constexpr inline size_t count_fields() noexcept
+		{
+			if constexpr (N == 0)
+			{
+				return 0;
+			}
+			else if constexpr ([]<size_t... Is>(std::index_sequence<Is...>) { return aggregate_takes_v<T, Is...>; }(std::make_index_sequence<N>{}))
+			{
+				return N;
+			}
+			else
+			{
+				return count_fields<T, N - 1>();
+			};
+		};
+
+		/**
+		 * @brief Maximum number of fields a reflected message may have
+		*/
+		constexpr inline size_t max_wire_fields_v = 16;
+
+		template <typename T>
+		struct is_std_array : std::false_type {};
+		template <typename T, size_t N>
+		struct is_std_array<std::array<T, N>> : std::true_type {};
+	};
+
+	/**
+	 * @brief Number of fields in an aggregate
+	*/
+	template <typename T>
+	requires std::is_aggregate_v<T>
+	constexpr inline size_t field_count_v = impl::count_fields<T, impl::max_wire_fields_v>();
+
+	/**
+	 * @brief Calls the given function with each field of an aggregate in declaration order
+	*/
+	template <typename T, typename OpT>
+	requires std::is_aggregate_v<std::remove_cvref_t<T>>
+	constexpr inline void for_each_field(T&& _value, OpT&& _op)
+	{
+		constexpr auto _count = field_count_v<std::remove_cvref_t<T>>;
+		static_assert(_count != 0, "message has no fields or too many to reflect");
+		if constexpr (_count == 1)
+		{
+			auto& [_0] = _value;
+			_op(_0);
+		}
+		else if constexpr (_count == 2)
+		{
+			auto& [_0, _1] = _value;
+			_op(_0); _op(_1);
+		}
+		else if constexpr (_count == 3)
+		{
+			auto& [_0, _1, _2] = _value;
+			_op(_0); _op(_1); _op(_2);
+		}
+		else if constexpr (_count == 4)
+		{
+			auto& [_0, _1, _2, _3] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3);
+		}
+		else if constexpr (_count == 5)
+		{
+			auto& [_0, _1, _2, _3, _4] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4);
+		}
+		else if constexpr (_count == 6)
+		{
+			auto& [_0, _1, _2, _3, _4, _5] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5);
+		}
+		else if constexpr (_count == 7)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6);
+		}
+		else if constexpr (_count == 8)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7);
+		}
+		else if constexpr (_count == 9)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8);
+		}
+		else if constexpr (_count == 10)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9);
+		}
+		else if constexpr (_count == 11)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9); _op(_10);
+		}
+		else if constexpr (_count == 12)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9); _op(_10); _op(_11);
+		}
+		else if constexpr (_count == 13)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9); _op(_10); _op(_11); _op(_12);
+		}
+		else if constexpr (_count == 14)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9); _op(_10); _op(_11); _op(_12); _op(_13);
+		}
+		else if constexpr (_count == 15)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9); _op(_10); _op(_11); _op(_12); _op(_13); _op(_14);
+		}
+		else if constexpr (_count == 16)
+		{
+			auto& [_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15] = _value;
+			_op(_0); _op(_1); _op(_2); _op(_3); _op(_4); _op(_5); _op(_6); _op(_7); _op(_8); _op(_9); _op(_10); _op(_11); _op(_12); _op(_13); _op(_14); _op(_15);
+		}
+	};
+
+	/**
+	 * @brief Satisfied by scalar types with a fixed wire encoding
+	*/
+	template <typename T>
+	concept cx_wire_scalar = std::integral<T> || std::is_enum_v<T> || std::same_as<T, float> || std::same_as<T, double>;
+
+	namespace impl
+	{
+		template <typename T>
+		constexpr inline size_t wire_size() noexcept;
+	};
+
+	/**
+	 * @brief Number of bytes a type occupies on the wire
+	*/
+	template <typename T>
+	constexpr inline size_t wire_size_v = impl::wire_size<T>();
+
+	/**
+	 * @brief Satisfied by types which can be encoded
+	*/
+	template <typename T>
+	concept cx_wire_message = std::is_aggregate_v<T> && !impl::is_std_array<T>::value && std::is_default_constructible_v<T> &&
+		(wire_size_v<T> != 0);
+
+	namespace impl
+	{
+		template <typename T>
+		constexpr inline size_t wire_size() noexcept
+		{
+			if constexpr (std::same_as<T, bool>)
+			{
+				return 1;
+			}
+			else if constexpr (cx_wire_scalar<T>)
+			{
+				return sizeof(T);
+			}
+			else if constexpr (is_std_array<T>::value)
+			{
+				return std::tuple_size_v<T> * wire_size<typename T::value_type>();
+			}
+			else if constexpr (std::is_array_v<T>)
+			{
+				static_assert(!std::is_array_v<T>, "use std::array for array fields");
+				return 0;
+			}
+			else if constexpr (std::is_aggregate_v<T>)
+			{
+				size_t _size = 0;
+				for_each_field(T{}, [&_size]<typename F>(const F&) { _size += wire_size<F>(); });
+				return _size;
+			}
+			else
+			{
+				static_assert(std::is_aggregate_v<T>, "type has no wire encoding");
+				return 0;
+			};
+		};
+
+		/**
+		 * @brief Unsigned integer with the same size as a scalar
+		*/
+		template <typename T>
+		using wire_uint_t = std::conditional_t<sizeof(T) == 1, uint8_t,
+			std::conditional_t<sizeof(T) == 2, uint16_t,
+			std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+		template <typename T>
+		constexpr inline void encode_value(const T& _value, std::byte*& _at) noexcept
+		{
+			if constexpr (std::same_as<T, bool>)
+			{
+				*_at++ = std::byte{ _value ? uint8_t{ 1 } : uint8_t{ 0 } };
+			}
+			else if constexpr (cx_wire_scalar<T>)
+			{
+				const auto _bits = to_network(std::bit_cast<wire_uint_t<T>>(_value));
+				const auto _bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(_bits);
+				_at = std::copy(_bytes.begin(), _bytes.end(), _at);
+			}
+			else if constexpr (is_std_array<T>::value)
+			{
+				using E = typename T::value_type;
+				if constexpr (std::integral<E> && !std::same_as<E, bool>)
+				{
+					if (!std::is_constant_evaluated())
+					{
+						copy_to_network<E>(_at, reinterpret_cast<const std::byte*>(_value.data()), _value.size());
+						_at += sizeof(E) * _value.size();
+						return;
+					};
+				};
+				for (auto& v : _value)
+				{
+					encode_value(v, _at);
+				};
+			}
+			else
+			{
+				for_each_field(_value, [&_at](const auto& _field) { encode_value(_field, _at); });
+			};
+		};
+
+		template <typename T>
+		constexpr inline void decode_value(T& _value, const std::byte*& _at) noexcept
+		{
+			if constexpr (std::same_as<T, bool>)
+			{
+				_value = *_at++ != std::byte{};
+			}
+			else if constexpr (cx_wire_scalar<T>)
+			{
+				std::array<std::byte, sizeof(T)> _bytes{};
+				std::copy(_at, _at + sizeof(T), _bytes.begin());
+				_at += sizeof(T);
+				_value = std::bit_cast<T>(from_network(std::bit_cast<wire_uint_t<T>>(_bytes)));
+			}
+			else if constexpr (is_std_array<T>::value)
+			{
+				using E = typename T::value_type;
+				if constexpr (std::integral<E> && !std::same_as<E, bool>)
+				{
+					if (!std::is_constant_evaluated())
+					{
+						copy_to_network<E>(reinterpret_cast<std::byte*>(_value.data()), _at, _value.size());
+						_at += sizeof(E) * _value.size();
+						return;
+					};
+				};
+				for (auto& v : _value)
+				{
+					decode_value(v, _at);
+				};
+			}
+			else
+			{
+				for_each_field(_value, [&_at](auto& _field) { decode_value(_field, _at); });
+			};
+		};
+	};
+
+	/**
+	 * @brief Encodes a message into a buffer in network byte order
+	 * @param _dest Destination, at least wire_size_v<T> bytes
+	 * @return Number of bytes written, always wire_size_v<T>
+	*/
+	template <cx_wire_message T>
+	constexpr inline size_t encode(const T& _message, std::span<std::byte> _dest) noexcept
+	{
+		JCLIB_ASSERT(_dest.size() >= wire_size_v<T>);
+		auto _at = _dest.data();
+		impl::encode_value(_message, _at);
+		return wire_size_v<T>;
+	};
+
+	/**
+	 * @brief Encodes a message into a fixed size byte array
+	*/
+	template <cx_wire_message T>
+	constexpr inline std::array<std::byte, wire_size_v<T>> encode(const T& _message) noexcept
+	{
+		std::array<std::byte, wire_size_v<T>> _out{};
+		encode(_message, std::span<std::byte>{ _out });
+		return _out;
+	};
+
+	/**
+	 * @brief Decodes a message from network byte order
+	 * @param _src Source, at least wire_size_v<T> bytes
+	*/
+	template <cx_wire_message T>
+	constexpr inline T decode(std::span<const std::byte> _src) noexcept
+	{
+		JCLIB_ASSERT(_src.size() >= wire_size_v<T>);
+		T _out{};
+		auto _at = _src.data();
+		impl::decode_value(_out, _at);
+		return _out;
+	};
+
+	/**
+	 * @brief Encodes a message straight into a stack send buffer and sends it
+	 * @return Number of bytes sent, may be short on a non-blocking stream socket, otherwise the socket error
+	*/
+	template <cx_wire_message T>
+	inline Result<size_t> send_message(socket_t _sock, const T& _message) noexcept
+	{
+		std::array<std::byte, wire_size_v<T>> _buffer;
+		encode(_message, std::span<std::byte>{ _buffer });
+		return send(_sock, _buffer.data(), _buffer.size());
+	};
+
+	/**
+	 * @brief Receives exactly one message from a blocking stream socket
+	 * @return The decoded message, ERR_CONNRESET if the peer closed first, otherwise the socket error
+	*/
+	template <cx_wire_message T>
+	inline Result<T> recv_message(socket_t _sock) noexcept
+	{
+		std::array<std::byte, wire_size_v<T>> _buffer;
+		size_t _have = 0;
+		while (_have != _buffer.size())
+		{
+			const auto _result = recv(_sock, _buffer.data() + _have, _buffer.size() - _have, static_cast<int>(MSG_WAITALL));
+			if (!_result)
+			{
+				return _result.error();
+			};
+			if (*_result == 0)
+			{
+				return ERR_CONNRESET;
+			};
+			_have += *_result;
+		};
+		return decode<T>(_buffer);
+	};
+
+};